@@ -0,0 +1,43 @@
+#include <py11/py.hpp>
+#include <iostream>
+
+// generated by build.sh: python2.7 ../tools/py11_freeze.py -o multiply_bundle.hpp multiply.py
+#include "multiply_bundle.hpp"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        cerr << "Usage: call_frozen funcname [args]\n";
+        return 1;
+    }
+
+    // start python without site, multiply is imported from the binary
+    py::init_options opt;
+    opt.no_site = true;
+    opt.ignore_environment = true;
+    py::interpreter interp(opt);
+
+    try {
+        py::install_frozen(py11_bundle, py11_bundle_magic);
+
+        py::obj func = py::import("multiply").attr(argv[1]);
+
+        py::list args;
+        args = {};
+        for (int i = 0; i < argc - 2; ++i) {
+            args.append(atoi(argv[i + 2]));
+        }
+
+        py::obj value = func.call(args.to_tuple());
+
+        printf("Result of call: %ld\n", value.as_long());
+        return 0;
+    }
+    catch (const py::err& e) {
+        cerr << e.what() << endl;
+        py::print_err();
+        return 1;
+    }
+}
@@ -5,18 +5,21 @@ using namespace std;
 
 int main(int argc, char *argv[])
 {
+    if (argc < 3) {
+        cerr << "Usage: call pythonfile funcname [args]\n";
+        return 1;
+    }
+
+    // start python, and set sys.argv and sys.path
+    py::init_options opt;
+    opt.argc = argc;
+    opt.argv = argv;
+    py::interpreter interp(opt);
+
     py::obj module, func, value;
     py::list args;
 
     try {
-        if (argc < 3) {
-            cerr << "Usage: call pythonfile funcname [args]\n";
-            return 1;
-        }
-
-        // for setting sys.path
-        py::set_arg(argc, argv);
-
         module = py::import(argv[1]); // throw exception if failed
 
         func = module.attr(argv[2]); // throw exception if not found
@@ -18,7 +18,7 @@
 * For example:<br>
 * <pre>
 * export CFLAGS="-I/usr/include/python2.7 -std=c++11"
-* export LDFLAGS=-lpython2.7
+* export LDFLAGS="-lpython2.7 -pthread"
 * </pre>
 *
 * @section doc Documents
@@ -32,8 +32,6 @@
 * <hr>
 * @todo add tutorial
 * @todo add exception handling
-* @todo add python init test, to co-exist with python for extending
-* @todo add python function extending support
 * @todo check co-existance with boost.python
 *
 * @defgroup utils Python utils
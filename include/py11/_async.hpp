@@ -0,0 +1,179 @@
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <exception>
+#include <tuple>
+
+namespace py{
+
+namespace details{
+
+/** convert a call result to a c++ value, with the GIL held.
+ */
+template<typename R> struct from_obj{
+    static R get(const obj& o)
+    {
+        return R(o);
+    }
+};
+
+template<> struct from_obj<long>{
+    static long get(const obj& o)
+    {
+        return o.as_long();
+    }
+};
+
+template<> struct from_obj<double>{
+    static double get(const obj& o)
+    {
+        return o.as_double();
+    }
+};
+
+/** the bytes of a str, embedded NULs included; a unicode is encoded to utf-8.
+ */
+template<> struct from_obj<std::string>{
+    static std::string get(const obj& o)
+    {
+        obj s = o;
+        if(!!s && PyUnicode_Check(s.p())){
+            s = PyUnicode_AsUTF8String(s.p());
+            if(!s)
+                throw val_err("async_call result encode failed");
+        }
+        if(!s || !PyString_Check(s.p()))
+            throw type_err("async_call result is not a str");
+        return std::string(PyString_AS_STRING(s.p()), PyString_GET_SIZE(s.p()));
+    }
+};
+
+template<> struct from_obj<void>{
+    static void get(const obj&)
+    {}
+};
+
+}; // ns details
+
+/** awaitable python call, see async_call().
+ */
+template<typename R, typename ...A> class async_call_awaiter{
+private:
+    struct node: public details::task_node{
+        async_call_awaiter* a;
+
+        void run()
+        {
+            try{
+                a->call();
+            }
+            catch(...){
+                a->_e = std::current_exception();
+            }
+        }
+
+        void complete()
+        {
+            if(a->_resume){
+                a->_resume(a->_h);
+                return;
+            }
+            // the result or the rethrown err may hold python objects
+            std::coroutine_handle<> h = a->_h;
+            gil_scoped_acquire gil;
+            h.resume();
+        }
+    };
+
+    executor& _ex;
+    obj _fn;
+    std::tuple<A...> _args;
+    std::function<void(std::coroutine_handle<>)> _resume;
+    std::coroutine_handle<> _h;
+    std::exception_ptr _e;
+    typename std::conditional<std::is_void<R>::value, char, R>::type _r;
+
+    template<size_t ...I> static obj invoke(const obj& fn, std::tuple<A...>& args, std::index_sequence<I...>)
+    {
+        return fn(std::get<I>(args)...);
+    }
+
+    void call()
+    {
+        // drop fn and args here, with the GIL held
+        obj fn = std::move(_fn);
+        std::tuple<A...> args = std::move(_args);
+        obj r = invoke(fn, args, std::index_sequence_for<A...>());
+        if constexpr(!std::is_void<R>::value)
+            _r = details::from_obj<R>::get(r);
+    }
+
+public:
+    /** with the GIL held, as fn is copied.
+     */
+    async_call_awaiter(executor& ex, const obj& fn, A... args)
+        :_ex(ex), _fn(fn), _args(std::move(args)...), _r()
+    {}
+
+    /** resume the coroutine through s, instead of on the executor thread.
+     * s is called without the GIL; it must take it before resuming if R holds
+     * python objects, or the call may raise, since the err holds them too.
+     */
+    async_call_awaiter& resume_on(std::function<void(std::coroutine_handle<>)> s)
+    {
+        _resume = std::move(s);
+        return *this;
+    }
+
+    bool await_ready()const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        _h = h;
+        node* n = new node;
+        n->a = this;
+        _ex.submit_node(n);
+    }
+
+    R await_resume()
+    {
+        if(_e)
+            std::rethrow_exception(_e);
+        if constexpr(!std::is_void<R>::value)
+            return std::move(_r);
+    }
+};
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+/** call fn(args...) on the executor thread, from a c++20 coroutine:
+ * <pre>
+ * long r = co_await py::async_call<long>(ex, fn, 1, 2.0);
+ * </pre>
+ * The coroutine is suspended without blocking its thread. The result is converted
+ * to R (long, double, std::string, void, or anything constructible from obj) with
+ * the GIL held, and python errors are rethrown from co_await.
+ * By default the coroutine resumes on the executor thread with the GIL held, until
+ * its next suspension; use resume_on() to hand it to another scheduler.
+ * fn is copied, so the awaitable must be created with the GIL held;
+ * args are converted to obj on the executor thread.
+ */
+template<typename R, typename ...A> async_call_awaiter<R, typename std::decay<A>::type...>
+    async_call(executor& ex, const obj& fn, A&&... args)
+{
+    return async_call_awaiter<R, typename std::decay<A>::type...>(ex, fn, std::forward<A>(args)...);
+}
+
+/**
+ * @}
+ */
+
+}; // ns py
+
+#endif // c++20 coroutines
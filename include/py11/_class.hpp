@@ -0,0 +1,458 @@
+#include <structmember.h>
+#include <deque>
+
+/** number of class_ methods a program can define, each in its own entry point.
+ */
+#ifndef PY11_METHOD_SLOTS
+#define PY11_METHOD_SLOTS 256
+#endif
+
+namespace py{
+
+namespace details{
+
+/** a python object holding a T inline, after the object header.
+ */
+template<typename T> struct instance{
+    PyObject_HEAD
+    T value;
+};
+
+/** the structmember type code of a field type, -1 if it needs a getset.
+ */
+template<typename D> struct member_code{
+    static const int value =
+        std::is_same<D, bool>::value ? T_BOOL :
+        std::is_same<D, signed char>::value ? T_BYTE :
+        std::is_same<D, unsigned char>::value ? T_UBYTE :
+        std::is_same<D, short>::value ? T_SHORT :
+        std::is_same<D, unsigned short>::value ? T_USHORT :
+        std::is_same<D, int>::value ? T_INT :
+        std::is_same<D, unsigned int>::value ? T_UINT :
+        std::is_same<D, long>::value ? T_LONG :
+        std::is_same<D, unsigned long>::value ? T_ULONG :
+        std::is_same<D, long long>::value ? T_LONGLONG :
+        std::is_same<D, unsigned long long>::value ? T_ULONGLONG :
+        std::is_same<D, float>::value ? T_FLOAT :
+        std::is_same<D, double>::value ? T_DOUBLE : -1;
+};
+
+/** byte offset of a field in instance<T>, without offsetof, which T may not allow.
+ */
+template<typename T, typename D> size_t field_offset(D T::*pm)
+{
+    typename std::aligned_storage<sizeof(instance<T>), alignof(instance<T>)>::type buf;
+    const instance<T>* i = (const instance<T>*)&buf;
+    return (const char*)&(i->value.*pm) - (const char*)i;
+}
+
+/** a member function bound to an instance, called by invoke().
+ */
+template<typename T, typename PM, typename R, typename... A> struct bound_method{
+    T* self;
+    PM pm;
+
+    R operator()(A... a)const
+    {
+        return (self->*pm)(std::forward<A>(a)...);
+    }
+};
+
+/** a method exported to python through a method descriptor.
+ */
+struct method_base: def_holder{
+    method_base(const char* n, const char* d):def_holder(n, d, NULL)
+    {}
+
+    /** called with the instance as self, and the args without it.
+     */
+    virtual PyObject* call(PyObject* self, PyObject* args) = 0;
+};
+
+/** the methods, by slot.
+ */
+inline method_base** method_table()
+{
+    static method_base* t[PY11_METHOD_SLOTS];
+    return t;
+}
+
+/** entry point of slot N; a method descriptor has no closure, so each
+ * method needs a distinct PyCFunction to find its method_base.
+ */
+template<size_t N> PyObject* method_slot(PyObject* self, PyObject* args)
+{
+    return method_table()[N]->call(self, args);
+}
+
+template<size_t... I> PyCFunction method_entry(size_t n, index_seq<I...>)
+{
+    static const PyCFunction t[] = { &method_slot<I>... };
+    return t[n];
+}
+
+/** give m a slot, for good.
+ * @return its entry point, NULL if all slots are taken
+ */
+inline PyCFunction add_method(method_base* m)
+{
+    static size_t n = 0;
+    if(n == PY11_METHOD_SLOTS)
+        return NULL;
+    method_table()[n] = m;
+    return method_entry(n++, typename make_index_seq<PY11_METHOD_SLOTS>::type());
+}
+
+template<typename T, typename PM, typename R, typename... A> struct method_holder: method_base{
+    PyTypeObject* type;
+    PM pm;
+
+    method_holder(const char* n, const char* d, PyTypeObject* t, PM m)
+        :method_base(n, d), type(t), pm(m)
+    {}
+
+    PyObject* call(PyObject* self, PyObject* args)
+    {
+        if(PyTuple_GET_SIZE(args) != sizeof...(A)){
+            PyErr_Format(PyExc_TypeError, "%.100s() takes exactly %d arguments (%d given)",
+                name.c_str(), (int)sizeof...(A), (int)PyTuple_GET_SIZE(args));
+            return NULL;
+        }
+        if(Py_TYPE(self) != type){
+            PyErr_Format(PyExc_TypeError, "%.100s() needs a %.100s instance", name.c_str(), type->tp_name);
+            return NULL;
+        }
+        bound_method<T, PM, R, A...> fn = {&((instance<T>*)self)->value, pm};
+        return invoke(sig<R, A...>(), fn, args, 0, typename make_index_seq<sizeof...(A)>::type());
+    }
+};
+
+
+/** getter and setter of a field without a structmember type code.
+ */
+template<typename T, typename D> struct field_access{
+    D T::*pm;
+
+    static PyObject* get(PyObject* self, void* closure)
+    {
+        field_access* f = (field_access*)closure;
+        try{
+            return ret_cast<D>::to_py(((instance<T>*)self)->value.*(f->pm));
+        }
+        catch(...){
+            return translate_exception();
+        }
+    }
+
+    static int set(PyObject* self, PyObject* v, void* closure)
+    {
+        if(!v){
+            PyErr_SetString(PyExc_TypeError, "can't delete a field");
+            return -1;
+        }
+        field_access* f = (field_access*)closure;
+        arg_cast<D> c;
+        if(!c.load(v, 0))
+            return -1;
+        try{
+            ((instance<T>*)self)->value.*(f->pm) = std::move(c.v);
+        }
+        catch(...){
+            translate_exception();
+            return -1;
+        }
+        return 0;
+    }
+};
+
+/** field types pointing into memory the setter's python arg owns.
+ */
+template<typename D> struct non_owning{
+    static const bool value = std::is_pointer<D>::value || std::is_same<D, str_view>::value;
+};
+
+/** the setter of a field, none for a non-owning type.
+ */
+template<typename T, typename D> setter field_setter(std::false_type)
+{
+    return &field_access<T, D>::set;
+}
+
+template<typename T, typename D> setter field_setter(std::true_type)
+{
+    return NULL;
+}
+
+/** the python type of T, and the definitions its descriptors point to.
+ */
+template<typename T> struct type_data{
+    PyTypeObject type;
+    initproc init;
+    std::string name;
+    std::string doc;
+    std::deque<std::string> names;
+    std::deque<PyMemberDef> members;
+    std::deque<PyGetSetDef> getsets;
+    std::deque<std::shared_ptr<void>> closures;
+
+    static type_data*& instance()
+    {
+        static type_data* d = NULL;
+        return d;
+    }
+};
+
+}; // ns details
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+/** a python type storing a c++ T inline in each object.
+ * T must be default constructible; init<A...>() adds a constructor from
+ * python args. Fields are member descriptors, with a getset for types
+ * without a structmember code, and methods are method descriptors calling
+ * trampolines as in py::def(); each method takes one of PY11_METHOD_SLOTS.
+ * The type can't be subclassed in python, and its objects are not tracked
+ * by the cycle collector. Define it once, with the GIL held.
+ */
+template<typename T> class class_{
+private:
+    static_assert(std::is_default_constructible<T>::value, "class_ needs a default constructible T");
+    static_assert(alignof(T) <= 8, "class_ can't align T beyond python's allocator");
+
+    typedef details::instance<T> inst_t;
+    typedef details::type_data<T> data_t;
+
+    data_t* _d;
+
+    static PyObject* tp_new(PyTypeObject* t, PyObject*, PyObject*)
+    {
+        PyObject* self = t->tp_alloc(t, 0);
+        if(!self)
+            return NULL;
+        try{
+            new (&((inst_t*)self)->value) T();
+        }
+        catch(...){
+            t->tp_free(self);
+            return details::translate_exception();
+        }
+        return self;
+    }
+
+    static void tp_dealloc(PyObject* self)
+    {
+        ((inst_t*)self)->value.~T();
+        Py_TYPE(self)->tp_free(self);
+    }
+
+    /** the type's tp_init, fixed at PyType_Ready so __init__ follows init<A...>().
+     */
+    static int tp_init_dispatch(PyObject* self, PyObject* args, PyObject* kw)
+    {
+        return data_t::instance()->init(self, args, kw);
+    }
+
+    static int tp_init_none(PyObject*, PyObject* args, PyObject* kw)
+    {
+        if(PyTuple_GET_SIZE(args) || (kw && PyDict_Size(kw))){
+            PyErr_SetString(PyExc_TypeError, "this constructor takes no arguments");
+            return -1;
+        }
+        return 0;
+    }
+
+    template<typename... A> struct construct{
+        T* self;
+
+        int operator()(A... a)const
+        {
+            *self = T(std::forward<A>(a)...);
+            return 0;
+        }
+    };
+
+    template<typename... A> static int tp_init(PyObject* self, PyObject* args, PyObject* kw)
+    {
+        if(kw && PyDict_Size(kw)){
+            PyErr_SetString(PyExc_TypeError, "this constructor takes no keyword arguments");
+            return -1;
+        }
+        if(PyTuple_GET_SIZE(args) != sizeof...(A)){
+            PyErr_Format(PyExc_TypeError, "this constructor takes exactly %d arguments (%d given)",
+                (int)sizeof...(A), (int)PyTuple_GET_SIZE(args));
+            return -1;
+        }
+        construct<A...> fn = {&((inst_t*)self)->value};
+        obj r(details::invoke(details::sig<int, A...>(), fn, args, 0,
+            typename details::make_index_seq<sizeof...(A)>::type()));
+        return !r ? -1 : 0;
+    }
+
+    /** put a descriptor in the type's dict.
+     * @throw val_err
+     */
+    void add(const char* name, PyObject* descr)
+    {
+        obj d(descr);
+        if(!d || PyDict_SetItemString(_d->type.tp_dict, name, d.p()) == -1)
+            throw val_err("class_ add failed");
+        PyType_Modified(&_d->type);
+    }
+
+    const char* keep(const char* s)
+    {
+        _d->names.push_back(s ? s : "");
+        return _d->names.back().c_str();
+    }
+
+    template<typename D> void field(const char* name, D T::*pm, bool readonly, const char* doc)
+    {
+        const int code = details::member_code<D>::value;
+        if(code != -1){
+            PyMemberDef m = {(char*)keep(name), code,
+                (Py_ssize_t)details::field_offset(pm),
+                readonly ? READONLY : 0, doc ? (char*)keep(doc) : NULL};
+            _d->members.push_back(m);
+            add(name, PyDescr_NewMember(&_d->type, &_d->members.back()));
+            return;
+        }
+        typedef details::field_access<T, D> access_t;
+        std::shared_ptr<access_t> a = std::make_shared<access_t>();
+        a->pm = pm;
+        _d->closures.push_back(a);
+        PyGetSetDef g = {(char*)keep(name), &access_t::get, readonly ? NULL
+            : details::field_setter<T, D>(std::integral_constant<bool, details::non_owning<D>::value>()),
+            doc ? (char*)keep(doc) : NULL, a.get()};
+        _d->getsets.push_back(g);
+        add(name, PyDescr_NewGetSet(&_d->type, &_d->getsets.back()));
+    }
+
+    template<typename PM, typename R, typename... A> class_& method(const char* name, PM pm, const char* doc)
+    {
+        typedef details::method_holder<T, PM, R, A...> method_t;
+        std::shared_ptr<method_t> m = std::make_shared<method_t>(name, doc, &_d->type, pm);
+        m->def.ml_meth = details::add_method(m.get());
+        if(!m->def.ml_meth)
+            throw val_err("class_ out of method slots, see PY11_METHOD_SLOTS");
+        _d->closures.push_back(m);
+        add(name, PyDescr_NewMethod(&_d->type, &m->def));
+        return *this;
+    }
+
+public:
+    /** create the python type.
+     * @param name  dotted name, such as "module.Type"
+     * @throw val_err
+     */
+    explicit class_(const char* name, const char* doc = NULL)
+    {
+        data_t*& d = data_t::instance();
+        d = new data_t();
+        _d = d;
+        _d->name = name;
+        _d->doc = doc ? doc : "";
+
+        PyTypeObject& t = _d->type;
+        Py_REFCNT(&t) = 1;
+        Py_TYPE(&t) = &PyType_Type;
+        t.tp_name = _d->name.c_str();
+        t.tp_doc = doc ? _d->doc.c_str() : NULL;
+        t.tp_basicsize = sizeof(inst_t);
+        t.tp_flags = Py_TPFLAGS_DEFAULT;
+        t.tp_new = &tp_new;
+        t.tp_init = &tp_init_dispatch;
+        _d->init = &tp_init_none;
+        t.tp_dealloc = &tp_dealloc;
+        t.tp_alloc = &PyType_GenericAlloc;
+        t.tp_free = &PyObject_Del;
+        if(PyType_Ready(&t) == -1)
+            throw val_err("class_ type failed");
+    }
+
+    /** construct from python args as T(A...).
+     */
+    template<typename... A> class_& init()
+    {
+        _d->init = &tp_init<A...>;
+        return *this;
+    }
+
+    /** a field, read and written through a member descriptor.
+     * Pointer and str_view fields can only be def_readonly(): a setter would
+     * keep a pointer into the python string it was given.
+     * @throw val_err
+     */
+    template<typename D> class_& def_readwrite(const char* name, D T::*pm, const char* doc = NULL)
+    {
+        static_assert(!details::non_owning<D>::value,
+            "def_readwrite can't store a non-owning field, use std::string or def_readonly");
+        field(name, pm, false, doc);
+        return *this;
+    }
+
+    template<typename D> class_& def_readonly(const char* name, D T::*pm, const char* doc = NULL)
+    {
+        field(name, pm, true, doc);
+        return *this;
+    }
+
+    /** a method, converted as py::def() does.
+     * @throw val_err
+     */
+    template<typename R, typename... A> class_& def(const char* name, R (T::*pm)(A...), const char* doc = NULL)
+    {
+        return method<R (T::*)(A...), R, A...>(name, pm, doc);
+    }
+
+    template<typename R, typename... A> class_& def(const char* name, R (T::*pm)(A...)const, const char* doc = NULL)
+    {
+        return method<R (T::*)(A...)const, R, A...>(name, pm, doc);
+    }
+
+    /** the type object.
+     */
+    obj type()const
+    {
+        return obj((PyObject*)&_d->type, true);
+    }
+
+    /** a new python object holding T(a...).
+     * @throw val_err if the type isn't defined
+     */
+    template<typename... A> static obj make(A&&... a)
+    {
+        data_t* d = data_t::instance();
+        if(!d)
+            throw val_err("class_ not defined");
+        obj self(d->type.tp_alloc(&d->type, 0));
+        if(!self)
+            throw val_err("class_ alloc failed");
+        try{
+            new (&((inst_t*)self.p())->value) T(std::forward<A>(a)...);
+        }
+        catch(...){
+            d->type.tp_free(self.transfer());
+            throw;
+        }
+        return self;
+    }
+
+    /** the T inside o, NULL if o isn't of this type.
+     */
+    static T* get(const obj& o)
+    {
+        data_t* d = data_t::instance();
+        if(!d || !o || Py_TYPE(o.p()) != &d->type)
+            return NULL;
+        return &((inst_t*)o.p())->value;
+    }
+};
+
+/**
+ * @}
+ */
+
+}; // ns py
@@ -0,0 +1,264 @@
+namespace py{
+
+/* hashing and comparison adapters
+*********************************/
+
+/** hash functor, consistent with python's hash().
+ * Exact str and int are hashed without calling into python.
+ * @throw type_err if unhashable
+ */
+struct hash{
+    size_t operator()(const obj& o)const
+    {
+        PyObject* p = o.p();
+        if(!p)
+            return 0;
+        if(PyString_CheckExact(p)){
+            long h = ((PyStringObject*)p)->ob_shash;
+            if(h != -1)
+                return h;
+        }
+        else if(PyInt_CheckExact(p)){
+            long h = PyInt_AS_LONG(p);
+            return h == -1 ? -2 : h;
+        }
+        return o.hash();
+    }
+};
+
+/** obj with its hash computed once.
+ * Use it as key for tuples and other immutable objects whose hash is not cached by python.
+ */
+class hashed_obj: public obj{
+private:
+    size_t _h;
+public:
+    hashed_obj():_h(0)
+    {}
+
+    /** ctor.
+     * @throw type_err if unhashable
+     */
+    hashed_obj(const obj& o):obj(o), _h(py::hash()(o))
+    {}
+
+    hashed_obj(obj&& o):obj(std::move(o)), _h(py::hash()(*this))
+    {}
+
+    /** the cached hash.
+     */
+    size_t cached_hash()const
+    {
+        return _h;
+    }
+};
+
+/** equality functor.
+ * Identity, exact str and exact int are compared without calling into python.
+ * @throw err if an __eq__ raises; the python error is left set
+ */
+struct equal_to{
+    bool operator()(const obj& a, const obj& b)const
+    {
+        PyObject* x = a.p();
+        PyObject* y = b.p();
+        if(x == y)
+            return true;
+        if(!x || !y)
+            return false;
+        if(Py_TYPE(x) == Py_TYPE(y)){
+            if(PyString_CheckExact(x)){
+                long hx = ((PyStringObject*)x)->ob_shash;
+                long hy = ((PyStringObject*)y)->ob_shash;
+                if(hx != -1 && hy != -1 && hx != hy)
+                    return false;
+                Py_ssize_t n = PyString_GET_SIZE(x);
+                return n == PyString_GET_SIZE(y)
+                    && memcmp(PyString_AS_STRING(x), PyString_AS_STRING(y), n) == 0;
+            }
+            if(PyInt_CheckExact(x))
+                return PyInt_AS_LONG(x) == PyInt_AS_LONG(y);
+        }
+        int r = PyObject_RichCompareBool(x, y, Py_EQ);
+        if(r == -1)
+            throw err("equal_to failed");
+        return r;
+    }
+
+    bool operator()(const hashed_obj& a, const hashed_obj& b)const
+    {
+        return a.cached_hash() == b.cached_hash()
+            && (*this)((const obj&)a, (const obj&)b);
+    }
+};
+
+namespace details{
+
+/** exact int, long, float or bool, whose rich comparison is a total order but for nan.
+ */
+inline bool is_real(PyObject* p)
+{
+    return PyInt_CheckExact(p) || PyLong_CheckExact(p) || PyFloat_CheckExact(p) || PyBool_Check(p);
+}
+
+/** double <, with nan greater than any other value and equal to itself.
+ */
+inline bool double_less(double a, double b)
+{
+    if(a != a)
+        return false;
+    if(b != b)
+        return true;
+    return a < b;
+}
+
+inline bool str_less(PyObject* a, PyObject* b)
+{
+    Py_ssize_t na = PyString_GET_SIZE(a);
+    Py_ssize_t nb = PyString_GET_SIZE(b);
+    int r = memcmp(PyString_AS_STRING(a), PyString_AS_STRING(b), na < nb ? na : nb);
+    return r < 0 || (r == 0 && na < nb);
+}
+
+/** rich comparison <, only used on builtin types that can't fail.
+ * A failure is still cleared and falls back to the address order.
+ */
+inline bool rich_less(PyObject* a, PyObject* b)
+{
+    int r = PyObject_RichCompareBool(a, b, Py_LT);
+    if(r == -1){
+        PyErr_Clear();
+        return std::less<PyObject*>()(a, b);
+    }
+    return r;
+}
+
+inline bool total_less(PyObject* x, PyObject* y);
+
+/** lexicographic order of the na items at a and the nb items at b, with total_less.
+ */
+inline bool items_less(PyObject** a, Py_ssize_t na, PyObject** b, Py_ssize_t nb)
+{
+    Py_ssize_t n = na < nb ? na : nb;
+    for(Py_ssize_t i = 0; i < n; i++){
+        if(total_less(a[i], b[i]))
+            return true;
+        if(total_less(b[i], a[i]))
+            return false;
+    }
+    return na < nb;
+}
+
+inline bool total_less(PyObject* x, PyObject* y)
+{
+    if(x == y)
+        return false;
+    if(!x || !y)
+        return !x;
+    PyTypeObject* tx = Py_TYPE(x);
+    PyTypeObject* ty = Py_TYPE(y);
+    if(tx == ty){
+        if(tx == &PyInt_Type)
+            return PyInt_AS_LONG(x) < PyInt_AS_LONG(y);
+        if(tx == &PyFloat_Type)
+            return double_less(PyFloat_AS_DOUBLE(x), PyFloat_AS_DOUBLE(y));
+        if(tx == &PyString_Type)
+            return str_less(x, y);
+        if(tx == &PyLong_Type || tx == &PyBool_Type || tx == &PyUnicode_Type)
+            return rich_less(x, y);
+        if(tx == &PyTuple_Type || tx == &PyList_Type)
+            return items_less(PySequence_Fast_ITEMS(x), Py_SIZE(x), PySequence_Fast_ITEMS(y), Py_SIZE(y));
+        return std::less<PyObject*>()(x, y);
+    }
+    bool rx = is_real(x);
+    bool ry = is_real(y);
+    if(rx && ry){
+        if(PyFloat_CheckExact(x) && Py_IS_NAN(PyFloat_AS_DOUBLE(x)))
+            return false;
+        if(PyFloat_CheckExact(y) && Py_IS_NAN(PyFloat_AS_DOUBLE(y)))
+            return true;
+        return rich_less(x, y);
+    }
+    if(rx != ry)
+        return rx;
+    int r = strcmp(tx->tp_name, ty->tp_name);
+    if(r)
+        return r < 0;
+    return std::less<PyTypeObject*>()(tx, ty);
+}
+
+}; // ns details
+
+/** ordering functor, a strict weak order usable with std::sort.
+ * Python's own < is not one (sets are partially ordered, nan is unordered,
+ * and any __lt__ may be), so it is only used where it is known to be total:
+ * NULL first, then exact int, long, float and bool compared by value (nan last),
+ * then other objects grouped by type name. Within a type, str and unicode
+ * compare by value, exact tuple and list compare their items with this same
+ * order, and any other object, including subclasses of builtins and objects
+ * with their own __lt__, by address. Use list::sort_by to sort by a custom key.
+ * It never calls python code and never throws.
+ */
+struct less{
+    bool operator()(const obj& a, const obj& b)const
+    {
+        return details::total_less(a.p(), b.p());
+    }
+};
+
+/** sort objs with py::less.
+ * The range is scanned once: if all items are exact int, float or str,
+ * they are sorted by a native comparison, without any per-type dispatch.
+ */
+template<typename It> void fast_sort(It first, It last)
+{
+    if(first == last)
+        return;
+    PyObject* p0 = first->p();
+    PyTypeObject* t = p0 ? Py_TYPE(p0) : NULL;
+    for(It i = first; i != last && t; ++i){
+        if(!i->p() || Py_TYPE(i->p()) != t)
+            t = NULL;
+    }
+
+    if(t == &PyInt_Type)
+        std::sort(first, last, [](const obj& a, const obj& b){
+            return PyInt_AS_LONG(a.p()) < PyInt_AS_LONG(b.p());
+        });
+    else if(t == &PyFloat_Type)
+        std::sort(first, last, [](const obj& a, const obj& b){
+            return details::double_less(PyFloat_AS_DOUBLE(a.p()), PyFloat_AS_DOUBLE(b.p()));
+        });
+    else if(t == &PyString_Type)
+        std::sort(first, last, [](const obj& a, const obj& b){
+            return details::str_less(a.p(), b.p());
+        });
+    else
+        std::sort(first, last, less());
+}
+
+}; // ns py
+
+namespace std{
+
+/** std::hash for py::obj, so it works as an unordered container key.
+ */
+template<> struct hash<py::obj>: public py::hash{
+};
+
+template<> struct hash<py::hashed_obj>{
+    size_t operator()(const py::hashed_obj& o)const
+    {
+        return o.cached_hash();
+    }
+};
+
+/** std::equal_to for py::obj; unlike most, it throws if python's __eq__ raises.
+ */
+template<> struct equal_to<py::obj>: public py::equal_to{
+};
+
+template<> struct equal_to<py::hashed_obj>: public py::equal_to{
+};
+
+}; // ns std
@@ -0,0 +1,206 @@
+#include <map>
+
+namespace py{
+
+namespace details{
+
+/** the exception injected into a call past its deadline.
+ * A BaseException, so that "except Exception" in python code doesn't swallow it.
+ */
+inline PyObject* deadline_exc()
+{
+    static PyObject* t = PyErr_NewException((char*)"py11.DeadlineExceeded", PyExc_BaseException, NULL);
+    return t;
+}
+
+struct deadline_call{
+    std::mutex m;
+    long thread_id;
+    bool done;
+    bool fired;
+
+    deadline_call(long id):thread_id(id), done(false), fired(false)
+    {}
+};
+
+/** one thread watching the deadlines of all calls.
+ * It never takes the GIL: calls past their deadline are handed to a python
+ * pending call, which injects the exception with the GIL held.
+ */
+class watchdog{
+private:
+    typedef std::chrono::steady_clock clock;
+    typedef std::multimap<clock::time_point, std::shared_ptr<deadline_call>> queue_t;
+
+    std::mutex _m;
+    std::condition_variable _cv;
+    queue_t _q;
+    std::vector<std::shared_ptr<deadline_call>> _due;
+    bool _scheduled;
+    bool _stop;
+    std::thread _th;
+
+    /** inject the exception into the due calls not done yet, with the GIL held.
+     */
+    static int pending_call(void*)
+    {
+        watchdog& w = instance();
+        std::vector<std::shared_ptr<deadline_call>> due;
+        {
+            std::lock_guard<std::mutex> l(w._m);
+            due.swap(w._due);
+            w._scheduled = false;
+        }
+        for(auto& c: due){
+            std::lock_guard<std::mutex> l(c->m);
+            if(!c->done){
+                PyThreadState_SetAsyncExc(c->thread_id, deadline_exc());
+                c->fired = true;
+            }
+        }
+        return 0;
+    }
+
+    /** ask python to run pending_call, with _m locked.
+     * @return false if python's queue is full, to retry later
+     */
+    bool schedule()
+    {
+        if(!_scheduled && Py_AddPendingCall(pending_call, NULL) == 0)
+            _scheduled = true;
+        return _scheduled;
+    }
+
+    void loop()
+    {
+        std::unique_lock<std::mutex> l(_m);
+        while(!_stop){
+            if(!_due.empty() && !schedule()){
+                _cv.wait_for(l, std::chrono::milliseconds(1));
+                continue;
+            }
+            if(_q.empty()){
+                _cv.wait(l);
+                continue;
+            }
+            queue_t::iterator it = _q.begin();
+            if(clock::now() < it->first){
+                _cv.wait_until(l, it->first);
+                continue;
+            }
+            _due.push_back(it->second);
+            _q.erase(it);
+        }
+    }
+
+public:
+    watchdog():_scheduled(false), _stop(false), _th([this]{ loop(); })
+    {}
+
+    ~watchdog()
+    {
+        {
+            std::lock_guard<std::mutex> l(_m);
+            _stop = true;
+            _cv.notify_one();
+        }
+        _th.join();
+    }
+
+    static watchdog& instance()
+    {
+        static watchdog w;
+        return w;
+    }
+
+    queue_t::iterator add(clock::time_point t, const std::shared_ptr<deadline_call>& c)
+    {
+        std::lock_guard<std::mutex> l(_m);
+        queue_t::iterator it = _q.insert(std::make_pair(t, c));
+        if(it == _q.begin())
+            _cv.notify_one();
+        return it;
+    }
+
+    void remove(const std::shared_ptr<deadline_call>& c)
+    {
+        std::lock_guard<std::mutex> l(_m);
+        for(queue_t::iterator it = _q.begin(); it != _q.end(); ++it){
+            if(it->second == c){
+                _q.erase(it);
+                return;
+            }
+        }
+    }
+};
+
+}; // ns details
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+/** call fn(*args, **kw), interrupting it if it runs longer than timeout.
+ * Past the deadline, a watchdog thread queues a python pending call that injects
+ * an exception into the calling thread; it is raised at the next python bytecode,
+ * so code blocked in C is interrupted only when it returns to python. As python
+ * runs pending calls on the main thread only, a call made from another thread
+ * is interrupted once the main thread runs python too. Either way the interpreter is
+ * left usable: the injected exception is cleared, or withdrawn if not raised yet.
+ * Threads are enabled if needed.
+ * @param kw  may be a null obj
+ * @throw timeout_err if the deadline was hit
+ * @throw the err throw_current() maps an other raised exception to
+ */
+template<typename Rep, typename Period> obj call_with_deadline(const obj& fn, const obj& args, const obj& kw,
+    std::chrono::duration<Rep, Period> timeout)
+{
+    if(!PyEval_ThreadsInitialized())
+        PyEval_InitThreads();
+    PyObject* exc = details::deadline_exc();
+    if(!exc)
+        throw err("call_with_deadline failed");
+
+    std::shared_ptr<details::deadline_call> c =
+        std::make_shared<details::deadline_call>(PyThreadState_Get()->thread_id);
+    details::watchdog& w = details::watchdog::instance();
+    w.add(std::chrono::steady_clock::now() + timeout, c);
+
+    PyObject* r = PyObject_Call(fn.p(), args.p(), kw.p());
+
+    bool fired;
+    {
+        std::lock_guard<std::mutex> l(c->m);
+        c->done = true;
+        fired = c->fired;
+    }
+    if(fired)
+        PyThreadState_SetAsyncExc(c->thread_id, NULL);
+    w.remove(c);
+
+    if(!r){
+        if(fired && PyErr_ExceptionMatches(exc)){
+            PyErr_Clear();
+            throw timeout_err("call timed out");
+        }
+        throw_current("call failed");
+    }
+    return r;
+}
+
+/** call fn(*args), interrupting it if it runs longer than timeout.
+ * @throw timeout_err if the deadline was hit
+ * @throw the err throw_current() maps an other raised exception to
+ */
+template<typename Rep, typename Period> obj call_with_deadline(const obj& fn, const obj& args,
+    std::chrono::duration<Rep, Period> timeout)
+{
+    return call_with_deadline(fn, args, obj(), timeout);
+}
+
+/**
+ * @}
+ */
+
+}; // ns py
@@ -0,0 +1,240 @@
+namespace py{
+
+/* deferred decref
+*****************/
+
+namespace details{
+
+/** decrefs pushed by one thread without the GIL.
+ * single producer (the owner thread), single consumer (a GIL holder).
+ */
+struct decref_ring{
+    static const size_t capacity = 256;
+    PyObject* items[capacity];
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+
+    decref_ring():head(0), tail(0)
+    {}
+
+    bool push(PyObject* p)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if(t - head.load(std::memory_order_acquire) == capacity)
+            return false;
+        items[t % capacity] = p;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** move the pending pointers to out, without decrefing them.
+     */
+    void take(std::vector<PyObject*>& out)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        for(; h != t; h++)
+            out.push_back(items[h % capacity]);
+        head.store(h, std::memory_order_release);
+    }
+};
+
+/** decref p now, taking the GIL, when it can't be deferred.
+ */
+inline void decref_with_gil(PyObject* p)noexcept
+{
+    PyGILState_STATE s = PyGILState_Ensure();
+    Py_DECREF(p);
+    PyGILState_Release(s);
+}
+
+/** decrefs that didn't fit in a ring, or were left by an exited thread.
+ */
+struct decref_node{
+    decref_node* next;
+    PyObject* p;
+};
+
+class decref_pool{
+private:
+    std::mutex _m;
+    std::vector<decref_ring*> _rings;
+    std::atomic<decref_node*> _overflow;
+    std::atomic<bool> _scheduled;
+
+    static int pending_call(void*)
+    {
+        decref_pool& d = instance();
+        d._scheduled.store(false);
+        d.drain();
+        return 0;
+    }
+
+    /** set while the current thread runs drain().
+     */
+    static bool& draining()
+    {
+        static thread_local bool b = false;
+        return b;
+    }
+
+public:
+    decref_pool():_overflow(NULL), _scheduled(false)
+    {}
+
+    static decref_pool& instance()
+    {
+        static decref_pool d;
+        return d;
+    }
+
+    void add(decref_ring* r)
+    {
+        std::lock_guard<std::mutex> l(_m);
+        _rings.push_back(r);
+    }
+
+    /** unregister a ring, and move what is left in it to the overflow list.
+     */
+    void remove(decref_ring* r)noexcept
+    {
+        {
+            std::lock_guard<std::mutex> l(_m);
+            _rings.erase(std::find(_rings.begin(), _rings.end(), r));
+        }
+        size_t h = r->head.load(std::memory_order_acquire);
+        size_t t = r->tail.load(std::memory_order_relaxed);
+        for(; h != t; h++){
+            PyObject* p = r->items[h % decref_ring::capacity];
+            if(!push_overflow(p))
+                decref_with_gil(p);
+        }
+        r->head.store(h);
+    }
+
+    /** @return false if out of memory, p is then left to the caller.
+     */
+    bool push_overflow(PyObject* p)noexcept
+    {
+        decref_node* n = new(std::nothrow) decref_node;
+        if(!n)
+            return false;
+        n->p = p;
+        n->next = _overflow.load(std::memory_order_relaxed);
+        while(!_overflow.compare_exchange_weak(n->next, n, std::memory_order_release, std::memory_order_relaxed))
+            ;
+        return true;
+    }
+
+    /** ask python to drain at its next pending-call check.
+     */
+    void schedule()
+    {
+        if(!_scheduled.exchange(true) && Py_AddPendingCall(pending_call, NULL) == -1)
+            _scheduled.store(false);
+    }
+
+    /** decref all pending objects, with the GIL held.
+     * The pointers are taken out under the lock and decrefed after it is
+     * released, as a __del__ may release objs or re-enter drain(). A nested
+     * call returns at once; the outer one loops until nothing is left.
+     */
+    void drain()
+    {
+        bool& busy = draining();
+        if(busy)
+            return;
+        busy = true;
+        std::vector<PyObject*> v;
+        while(true){
+            {
+                std::lock_guard<std::mutex> l(_m);
+                for(auto r: _rings)
+                    r->take(v);
+            }
+            decref_node* n = _overflow.exchange(NULL, std::memory_order_acquire);
+            while(n){
+                decref_node* next = n->next;
+                v.push_back(n->p);
+                delete n;
+                n = next;
+            }
+            if(v.empty())
+                break;
+            for(auto p: v)
+                Py_DECREF(p);
+            v.clear();
+        }
+        busy = false;
+    }
+};
+
+/** the ring of the current thread, registered on first use.
+ */
+class thread_decrefs{
+private:
+    decref_ring* _r;
+public:
+    /** @throw std::bad_alloc
+     */
+    thread_decrefs()
+    {
+        std::unique_ptr<decref_ring> r(new decref_ring);
+        decref_pool::instance().add(r.get());
+        _r = r.release();
+    }
+
+    ~thread_decrefs()
+    {
+        decref_pool::instance().remove(_r);
+        delete _r;
+    }
+
+    void push(PyObject* p)noexcept
+    {
+        if(!_r->push(p) && !decref_pool::instance().push_overflow(p)){
+            decref_with_gil(p);
+            return;
+        }
+        decref_pool::instance().schedule();
+    }
+};
+
+/** queue a decref for a GIL holder.
+ * Never throws: without memory for the queue, it blocks on the GIL instead.
+ */
+inline void defer_decref(PyObject* p)noexcept
+{
+    try{
+        static thread_local thread_decrefs t;
+        t.push(p);
+    }
+    catch(...){
+        decref_with_gil(p);
+    }
+}
+
+}; // ns details
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+/** decref all objs released by threads without the GIL.
+ * Must be called with the GIL held. It also runs at GIL scope exits
+ * (including each executor batch), and as a python pending call.
+ * Only active when compiled with PY11_DEFERRED_DECREF=1.
+ */
+inline void drain_decrefs()
+{
+#if PY11_DEFERRED_DECREF
+    details::decref_pool::instance().drain();
+#endif
+}
+
+/**
+ * @}
+ */
+
+}; // ns py
@@ -0,0 +1,418 @@
+namespace py{
+
+namespace details{
+
+template<size_t... I> struct index_seq{};
+
+template<size_t N, size_t... I> struct make_index_seq: make_index_seq<N - 1, N - 1, I...>{};
+
+template<size_t... I> struct make_index_seq<0, I...>{
+    typedef index_seq<I...> type;
+};
+
+/** set a TypeError about argument i, and fail.
+ */
+inline bool arg_type_error(size_t i, const char* expected, PyObject* p)
+{
+    PyErr_Format(PyExc_TypeError, "argument %d must be %.50s, not %.50s",
+        (int)i + 1, expected, Py_TYPE(p)->tp_name);
+    return false;
+}
+
+/** python to c++ argument conversion.
+ * load() borrows p, and sets a python error when it returns false.
+ * The converted value lives in v until the call returns.
+ */
+template<typename T, typename = void> struct arg_cast;
+
+/** integers, with a fast path for exact ints, and range checks.
+ */
+template<typename T> struct arg_cast<T, typename std::enable_if<
+    std::is_integral<T>::value && !std::is_same<T, bool>::value>::type>{
+    T v;
+
+    bool store(long long x)
+    {
+        if(std::is_unsigned<T>::value ? x < 0 || (unsigned long long)x > std::numeric_limits<T>::max()
+            : x < (long long)std::numeric_limits<T>::min() || x > (long long)std::numeric_limits<T>::max()){
+            PyErr_SetString(PyExc_OverflowError, "integer argument out of range");
+            return false;
+        }
+        v = (T)x;
+        return true;
+    }
+
+    bool load(PyObject* p, size_t i)
+    {
+        if(PyInt_CheckExact(p))
+            return store(PyInt_AS_LONG(p));
+        if(!PyInt_Check(p) && !PyLong_Check(p))
+            return arg_type_error(i, "an integer", p);
+        if(std::is_unsigned<T>::value && sizeof(T) == sizeof(long long) && PyLong_Check(p)){
+            unsigned long long x = PyLong_AsUnsignedLongLong(p);
+            if(x == (unsigned long long)-1 && PyErr_Occurred())
+                return false;
+            v = (T)x;
+            return true;
+        }
+        long long x = PyLong_AsLongLong(p);
+        if(x == -1 && PyErr_Occurred())
+            return false;
+        return store(x);
+    }
+};
+
+template<> struct arg_cast<bool>{
+    bool v;
+
+    bool load(PyObject* p, size_t)
+    {
+        if(p == Py_True || p == Py_False){
+            v = p == Py_True;
+            return true;
+        }
+        int r = PyObject_IsTrue(p);
+        v = r == 1;
+        return r != -1;
+    }
+};
+
+template<typename T> struct arg_cast<T, typename std::enable_if<
+    std::is_floating_point<T>::value>::type>{
+    T v;
+
+    bool load(PyObject* p, size_t i)
+    {
+        if(PyFloat_CheckExact(p)){
+            v = (T)PyFloat_AS_DOUBLE(p);
+            return true;
+        }
+        if(!PyNumber_Check(p))
+            return arg_type_error(i, "a float", p);
+        double x = PyFloat_AsDouble(p);
+        if(x == -1.0 && PyErr_Occurred())
+            return false;
+        v = (T)x;
+        return true;
+    }
+};
+
+/** strings point into the python str, valid during the call.
+ */
+template<> struct arg_cast<const char*>{
+    const char* v;
+
+    bool load(PyObject* p, size_t i)
+    {
+        if(!PyString_Check(p))
+            return arg_type_error(i, "str", p);
+        v = PyString_AS_STRING(p);
+        return true;
+    }
+};
+
+template<> struct arg_cast<str_view>{
+    str_view v;
+
+    bool load(PyObject* p, size_t i)
+    {
+        if(!PyString_Check(p))
+            return arg_type_error(i, "str", p);
+        v = str_view(PyString_AS_STRING(p), PyString_GET_SIZE(p));
+        return true;
+    }
+};
+
+template<> struct arg_cast<std::string>{
+    std::string v;
+
+    bool load(PyObject* p, size_t i)
+    {
+        if(!PyString_Check(p))
+            return arg_type_error(i, "str", p);
+        v.assign(PyString_AS_STRING(p), PyString_GET_SIZE(p));
+        return true;
+    }
+};
+
+/** obj and the typed wrappers, with their type check.
+ */
+template<typename T> struct arg_cast<T, typename std::enable_if<
+    std::is_base_of<obj, T>::value>::type>{
+    T v;
+
+    bool load(PyObject* p, size_t i)
+    {
+        try{
+            v = obj(p, true);
+        }
+        catch(const err& e){
+            PyErr_Format(PyExc_TypeError, "argument %d: %.100s, got %.50s",
+                (int)i + 1, e.what(), Py_TYPE(p)->tp_name);
+            return false;
+        }
+        return true;
+    }
+};
+
+/** c++ to python result conversion, to a new reference.
+ */
+template<typename T, typename = void> struct ret_cast;
+
+template<typename T> struct ret_cast<T, typename std::enable_if<
+    std::is_integral<T>::value && !std::is_same<T, bool>::value>::type>{
+    static PyObject* to_py(T x)
+    {
+        if(std::is_unsigned<T>::value ? (unsigned long long)x <= (unsigned long)std::numeric_limits<long>::max()
+            : (long long)x >= std::numeric_limits<long>::min() && (long long)x <= std::numeric_limits<long>::max())
+            return PyInt_FromLong((long)x);
+        return std::is_unsigned<T>::value ? PyLong_FromUnsignedLongLong((unsigned long long)x)
+            : PyLong_FromLongLong((long long)x);
+    }
+};
+
+template<> struct ret_cast<bool>{
+    static PyObject* to_py(bool x)
+    {
+        return PyBool_FromLong(x);
+    }
+};
+
+template<typename T> struct ret_cast<T, typename std::enable_if<
+    std::is_floating_point<T>::value>::type>{
+    static PyObject* to_py(T x)
+    {
+        return PyFloat_FromDouble(x);
+    }
+};
+
+template<> struct ret_cast<const char*>{
+    static PyObject* to_py(const char* s)
+    {
+        if(!s)
+            Py_RETURN_NONE;
+        return PyString_FromString(s);
+    }
+};
+
+template<> struct ret_cast<str_view>{
+    static PyObject* to_py(str_view s)
+    {
+        return PyString_FromStringAndSize(s.data(), s.size());
+    }
+};
+
+template<> struct ret_cast<std::string>{
+    static PyObject* to_py(const std::string& s)
+    {
+        return PyString_FromStringAndSize(s.data(), s.size());
+    }
+};
+
+/** a returned obj hands over its reference; a null one is None, unless an error is set.
+ */
+template<typename T> struct ret_cast<T, typename std::enable_if<
+    std::is_base_of<obj, T>::value>::type>{
+    static PyObject* to_py(obj&& o)
+    {
+        PyObject* p = o.transfer();
+        if(!p && !PyErr_Occurred())
+            Py_RETURN_NONE;
+        return p;
+    }
+
+    static PyObject* to_py(const obj& o)
+    {
+        return to_py(obj(o));
+    }
+};
+
+template<typename R> struct invoker{
+    template<typename F, typename... X> static PyObject* call(F fn, X&&... x)
+    {
+        return ret_cast<typename std::decay<R>::type>::to_py(fn(std::forward<X>(x)...));
+    }
+};
+
+template<> struct invoker<void>{
+    template<typename F, typename... X> static PyObject* call(F fn, X&&... x)
+    {
+        fn(std::forward<X>(x)...);
+        Py_RETURN_NONE;
+    }
+};
+
+/** set the python error for a c++ exception escaping to python.
+ * An err keeps the python error it was thrown for, if still set.
+ */
+inline PyObject* translate_exception()
+{
+    try{
+        throw;
+    }
+    catch(const err& e){
+        if(!PyErr_Occurred())
+            PyErr_SetString(PyExc_RuntimeError, e.what() ? e.what() : "c++ error");
+    }
+    catch(const std::exception& e){
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+    }
+    catch(...){
+        PyErr_SetString(PyExc_RuntimeError, "unknown c++ exception");
+    }
+    return NULL;
+}
+
+/** a c++ signature, to deduce it apart from the callable.
+ */
+template<typename R, typename... A> struct sig{};
+
+/** unpack args from position first on, call fn, and convert its result.
+ */
+template<typename R, typename... A, typename F, size_t... I>
+PyObject* invoke(sig<R, A...>, F fn, PyObject* args, size_t first, index_seq<I...>)
+{
+    std::tuple<arg_cast<typename std::decay<A>::type>...> cs;
+    bool ok = true;
+    int order[] = { 0, (ok = ok && std::get<I>(cs).load(PyTuple_GET_ITEM(args, first + I), I), 0)... };
+    (void)order;
+    (void)args;
+    (void)first;
+    if(!ok)
+        return NULL;
+    try{
+        return invoker<R>::call(fn, static_cast<A&&>(std::get<I>(cs).v)...);
+    }
+    catch(...){
+        return translate_exception();
+    }
+}
+
+/** a function exported to python, owned by the capsule its PyCFunction holds as self.
+ */
+struct def_holder{
+    PyMethodDef def;
+    std::string name;
+    std::string doc;
+
+    def_holder(const char* n, const char* d, PyCFunction f):name(n), doc(d ? d : "")
+    {
+        def.ml_name = name.c_str();
+        def.ml_meth = f;
+        def.ml_flags = METH_VARARGS;
+        def.ml_doc = d ? doc.c_str() : NULL;
+    }
+
+    virtual ~def_holder()
+    {}
+};
+
+template<typename R, typename... A> struct fn_holder: def_holder{
+    R (*fn)(A...);
+
+    fn_holder(const char* n, const char* d, R (*f)(A...)):def_holder(n, d, &trampoline), fn(f)
+    {}
+
+    static PyObject* trampoline(PyObject* self, PyObject* args)
+    {
+        fn_holder* h = (fn_holder*)PyCapsule_GetPointer(self, NULL);
+        if(PyTuple_GET_SIZE(args) != sizeof...(A)){
+            PyErr_Format(PyExc_TypeError, "%.100s() takes exactly %d arguments (%d given)",
+                h->name.c_str(), (int)sizeof...(A), (int)PyTuple_GET_SIZE(args));
+            return NULL;
+        }
+        return invoke(sig<R, A...>(), h->fn, args, 0, typename make_index_seq<sizeof...(A)>::type());
+    }
+};
+
+inline void def_holder_free(PyObject* cap)
+{
+    delete (def_holder*)PyCapsule_GetPointer(cap, NULL);
+}
+
+/** a PyCFunction calling h, which it takes over.
+ * @throw val_err
+ */
+inline obj make_function(def_holder* h, PyObject* module_name)
+{
+    obj cap(PyCapsule_New(h, NULL, def_holder_free));
+    if(!cap){
+        delete h;
+        throw val_err("def failed");
+    }
+    PyObject* f = PyCFunction_NewEx(&h->def, cap.p(), module_name);
+    if(!f)
+        throw val_err("def failed");
+    return f;
+}
+
+}; // ns details
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+/** a python function calling the c++ function fn.
+ * The trampoline is generated from fn's signature: positional args are
+ * converted straight from the args tuple, and the result to a new reference.
+ * Supported types are integers, bool, floating point, const char*, str_view,
+ * std::string, obj and the typed wrappers; fn may also return void.
+ * C++ exceptions become python RuntimeErrors, or keep the python error of an err.
+ * @throw val_err
+ */
+template<typename R, typename... A> obj def(const char* name, R (*fn)(A...), const char* doc = NULL)
+{
+    return details::make_function(new details::fn_holder<R, A...>(name, doc, fn), NULL);
+}
+
+/** build a python module of c++ functions, for an extension's init function
+ * or for an embedding program.
+ */
+class module_builder{
+private:
+    obj _m;
+
+public:
+    /** create the module, and add it to sys.modules.
+     * @throw val_err
+     */
+    explicit module_builder(const char* name, const char* doc = NULL)
+    {
+        PyObject* m = Py_InitModule4(name, NULL, doc, NULL, PYTHON_API_VERSION);
+        if(!m)
+            throw val_err("module_builder failed");
+        _m = obj(m, true);
+    }
+
+    /** add fn, see py::def().
+     * @throw val_err
+     */
+    template<typename R, typename... A> module_builder& def(const char* name, R (*fn)(A...), const char* doc = NULL)
+    {
+        obj module_name(PyModule_GetName(_m.p()));
+        obj f = details::make_function(new details::fn_holder<R, A...>(name, doc, fn), module_name.p());
+        return add(name, f);
+    }
+
+    /** add an object.
+     * @throw val_err
+     */
+    module_builder& add(const char* name, const obj& v)
+    {
+        if(PyModule_AddObject(_m.p(), name, obj(v).transfer()) == -1)
+            throw val_err("module add failed");
+        return *this;
+    }
+
+    const obj& module()const
+    {
+        return _m;
+    }
+};
+
+/**
+ * @}
+ */
+
+}; // ns py
@@ -4,15 +4,15 @@ namespace py{
  */
 class dict: public obj{
 protected:
-    void type_check(PyObject* p)noexcept(!PY11_ENFORCE)
+    void type_check(PyObject* p)noexcept(!PY11_ENFORCE_DICT)
     {
-        if(PY11_ENFORCE && p){
-            if(!PyDict_Check(p))
+        if(PY11_ENFORCE_DICT && p && !PyDict_CheckExact(p)){
+            if(PY11_ENFORCE_DICT >= 2 || !PyDict_Check(p))
                 throw type_err("creating dict failed");
         }
     }
     
-    void type_check(const obj& o)noexcept(!PY11_ENFORCE)
+    void type_check(const obj& o)noexcept(!PY11_ENFORCE_DICT)
     {
         type_check((PyObject*)o.p());
     }
@@ -21,14 +21,19 @@ public:
     /** ctor.
      */
     dict()=default;
+
+    /** take a new reference known to be a dict, without checking.
+     */
+    dict(PyObject* p, unchecked_t)noexcept:obj(p)
+    {}
     
-    dict(const obj& o)noexcept(!PY11_ENFORCE)
+    dict(const obj& o)noexcept(!PY11_ENFORCE_DICT)
     {
         type_check(o);
         enter(o.p());
     }
     
-    dict& operator=(const obj& o)noexcept(!PY11_ENFORCE)
+    dict& operator=(const obj& o)noexcept(!PY11_ENFORCE_DICT)
     {
         if(o.p()!=_p){
             type_check(o);
@@ -38,13 +43,13 @@ public:
         return *this;
     }
 
-    dict(obj&& o)noexcept(!PY11_ENFORCE)
+    dict(obj&& o)noexcept(!PY11_ENFORCE_DICT)
     {
         type_check(o);
         _p = o.transfer();
     }
     
-    dict& operator=(obj&& o)noexcept(!PY11_ENFORCE)
+    dict& operator=(obj&& o)noexcept(!PY11_ENFORCE_DICT)
     {
         if(o.p()!=_p){
             type_check(o);
@@ -128,35 +133,57 @@ public:
 
     /** get item.
      * Warning, a new obj will be got! not a reference to the original one!
-     * @throw index_err
+     * @throw key_err
      */
     const obj operator [](const obj& k)const
     {
         PyObject* p = PyDict_GetItem(_p, k.p());
         if(!p){
-            throw index_err("non-existing item");
+            throw key_err("non-existing item");
+        }
+        return obj(p, true);
+    }
+
+    /** get item, without throwing.
+     * A miss sets no python error, so it costs no more than a hit. The key is
+     * hashed once and looked up with that hash, so that unlike PyDict_GetItem,
+     * an unhashable key or a failing __eq__ is reported, not taken for a miss.
+     */
+    expected<obj> try_get(const obj& k, err_policy policy = err_policy::clear)const
+    {
+        long h;
+        if(!PyString_CheckExact(k.p()) || (h = ((PyStringObject*)k.p())->ob_shash) == -1){
+            h = PyObject_Hash(k.p());
+            if(h == -1)
+                return details::take_error(policy, "unhashable key", err_kind::type);
         }
-        return p;
+        PyDictObject* d = (PyDictObject*)_p;
+        PyDictEntry* e = d->ma_lookup(d, k.p(), h);
+        if(!e)
+            return details::take_error(policy, "try_get failed");
+        if(!e->me_value)
+            return error(err_kind::key, "non-existing item");
+        return obj(e->me_value, true);
     }
     
     /** set_item.
-     * @throw index_err
+     * @throw the err throw_current() maps the raised exception to, type_err for an unhashable key
      */
     void set_item(const obj& k, const obj& value)
     {
         int r = PyDict_SetItem(_p, k.p(), value.p());
         if(r == -1)
-            throw index_err("set_item failed");
+            throw_current("set_item failed");
     }
     
     /** del_item.
-     * @throw index_err
+     * @throw the err throw_current() maps the raised exception to, key_err for a missing key
      */
     void del_item(const obj& k)
     {
         int r = PyDict_DelItem(_p, k.p());
         if(r == -1)
-            throw index_err("del_item failed");
+            throw_current("del_item failed");
     }
     
     /** items.
@@ -166,7 +193,7 @@ public:
     {
         if(!_p)
             throw val_err("items failed");
-        return PyDict_Items(_p);
+        return list(PyDict_Items(_p), unchecked);
     }
     
     /** keys.
@@ -176,7 +203,7 @@ public:
     {
         if(!_p)
             throw val_err("keys failed");
-        return PyDict_Keys(_p);
+        return list(PyDict_Keys(_p), unchecked);
     }
             
     /** values.
@@ -186,7 +213,7 @@ public:
     {
         if(!_p)
             throw val_err("values failed");
-        return PyDict_Values(_p);
+        return list(PyDict_Values(_p), unchecked);
     }
             
     /** clear.
@@ -206,7 +233,7 @@ public:
     {
         if(!_p)
             throw val_err("copy failed");
-        return PyDict_Copy(_p);
+        return dict(PyDict_Copy(_p), unchecked);
     }
     
     /** update.
@@ -3,21 +3,152 @@ namespace py{
 /* exceptions
 ************/
 
+namespace details{
+
+/** a fetched python error, owned; formatted on demand.
+ */
+struct err_state{
+    PyObject* type;
+    PyObject* value;
+    PyObject* trace;
+    std::string text;
+    bool formatted;
+
+    err_state(PyObject* t, PyObject* v, PyObject* tb)
+        :type(t), value(v), trace(tb), formatted(false)
+    {
+        Py_XINCREF(type);
+        Py_XINCREF(value);
+        Py_XINCREF(trace);
+    }
+
+    ~err_state()
+    {
+        if(!Py_IsInitialized())
+            return;
+        PyGILState_STATE s = PyGILState_Ensure();
+        Py_XDECREF(type);
+        Py_XDECREF(value);
+        Py_XDECREF(trace);
+        PyGILState_Release(s);
+    }
+
+    /** "Type: value (file:line)", with the GIL held.
+     */
+    void format()
+    {
+        formatted = true;
+        PyErr_NormalizeException(&type, &value, &trace);
+        PyObject* name = type ? PyObject_GetAttrString(type, "__name__") : NULL;
+        if(name && PyString_Check(name))
+            text = PyString_AS_STRING(name);
+        Py_XDECREF(name);
+        PyObject* str = value ? PyObject_Str(value) : NULL;
+        if(str && PyString_Check(str) && PyString_GET_SIZE(str)){
+            text += ": ";
+            text += PyString_AS_STRING(str);
+        }
+        Py_XDECREF(str);
+        if(trace && PyTraceBack_Check(trace)){
+            PyTracebackObject* tb = (PyTracebackObject*)trace;
+            while(tb->tb_next)
+                tb = tb->tb_next;
+            PyObject* file = tb->tb_frame->f_code->co_filename;
+            if(PyString_Check(file)){
+                text += " (";
+                text += PyString_AS_STRING(file);
+                text += ":" + std::to_string(tb->tb_lineno) + ")";
+            }
+        }
+        PyErr_Clear();
+    }
+};
+
+}; // ns details
+
 /** exception: err.
+ * The pending python error, if any, is captured when thrown, and left set so
+ * print_err() still works. It is formatted into what() only on demand.
+ * Construct it with the GIL held to capture the python error.
  */
 class err: public std::exception{
 protected:
     const char* _what;
+    std::shared_ptr<details::err_state> _state;
+
+    void capture()
+    {
+        if(!gil_held() || !PyErr_Occurred())
+            return;
+        PyObject *t, *v, *tb;
+        PyErr_Fetch(&t, &v, &tb);
+        _state = std::make_shared<details::err_state>(t, v, tb);
+        PyErr_Restore(t, v, tb);
+    }
+
 public:
     err():_what(NULL)
-    {}
+    {
+        capture();
+    }
     
     err(const char* what):_what(what)
-    {}
+    {
+        capture();
+    }
     
+    /** the message, followed by the python error captured.
+     */
     virtual const char* what()const noexcept
     {
-        return _what;
+        if(!_state)
+            return _what;
+        if(!_state->formatted){
+            if(!Py_IsInitialized())
+                return _what;
+            PyGILState_STATE s = PyGILState_Ensure();
+            PyObject *t, *v, *tb;
+            PyErr_Fetch(&t, &v, &tb);
+            _state->format();
+            PyErr_Restore(t, v, tb);
+            if(_what && !_state->text.empty())
+                _state->text = std::string(_what) + ": " + _state->text;
+            else if(_what)
+                _state->text = _what;
+            PyGILState_Release(s);
+        }
+        return _state->text.c_str();
+    }
+
+    /** the python exception type, NULL if none was set.
+     */
+    PyObject* type()const
+    {
+        return _state ? _state->type : NULL;
+    }
+
+    /** the python exception value, maybe NULL or not normalized.
+     */
+    PyObject* value()const
+    {
+        return _state ? _state->value : NULL;
+    }
+
+    PyObject* traceback()const
+    {
+        return _state ? _state->trace : NULL;
+    }
+
+    /** set the captured python error again, for example before returning to python.
+     */
+    void restore()const
+    {
+        if(!_state)
+            return;
+        Py_XINCREF(_state->type);
+        Py_XINCREF(_state->value);
+        Py_XINCREF(_state->trace);
+        PyErr_Restore(_state->type, _state->value, _state->trace);
     }
 };
 
@@ -30,6 +161,22 @@ public:
     {}
 };
 
+/** exception: key_err, for KeyError.
+ */
+class key_err: public index_err{
+public:
+    key_err(const char* what):index_err(what)
+    {}
+};
+
+/** exception: attr_err, for AttributeError.
+ */
+class attr_err: public index_err{
+public:
+    attr_err(const char* what):index_err(what)
+    {}
+};
+
 /** exception: type_err.
  */
 class type_err: public err{
@@ -62,5 +209,308 @@ public:
     {}
 };
 
+/** exception: timeout_err.
+ */
+class timeout_err: public err{
+public:
+    timeout_err(const char* what):err(what)
+    {}
+};
+
+/** exception: stop_iteration, for StopIteration.
+ */
+class stop_iteration: public err{
+public:
+    stop_iteration(const char* what):err(what)
+    {}
+};
+
+namespace details{
+
+inline std::vector<void(*)()>& fini_hooks();
+
+typedef void (*err_thrower)(const char*);
+
+template<typename E> [[noreturn]] void throw_as(const char* what)
+{
+    throw E(what);
+}
+
+/** python exception types and the err thrown for them, searched last to first.
+ * The built-in entries come first; the registered ones after them own a reference.
+ */
+inline std::vector<std::pair<PyObject*, err_thrower>>& err_table()
+{
+    static std::vector<std::pair<PyObject*, err_thrower>> t = {
+        {PyExc_EnvironmentError, &throw_as<io_err>},
+        {PyExc_EOFError, &throw_as<eof_err>},
+        {PyExc_ValueError, &throw_as<val_err>},
+        {PyExc_TypeError, &throw_as<type_err>},
+        {PyExc_StopIteration, &throw_as<stop_iteration>},
+        {PyExc_AttributeError, &throw_as<attr_err>},
+        {PyExc_IndexError, &throw_as<index_err>},
+        {PyExc_KeyError, &throw_as<key_err>},
+    };
+    return t;
+}
+
+/** number of built-in err_table() entries.
+ */
+inline size_t err_builtins()
+{
+    static const size_t n = err_table().size();
+    return n;
+}
+
+/** drop the registered entries, before finalizing.
+ */
+inline void clear_registered()
+{
+    auto& t = err_table();
+    for(size_t i = err_builtins(); i < t.size(); i++)
+        Py_DECREF(t[i].first);
+    t.resize(err_builtins());
+}
+
+inline void add_registered(PyObject* type, err_thrower f)
+{
+    static bool hooked = false;
+    if(!hooked){
+        hooked = true;
+        fini_hooks().push_back(&clear_registered);
+    }
+    err_builtins();
+    Py_INCREF(type);
+    err_table().push_back({type, f});
+}
+
+}; // ns details
+
+/** throw E for python exceptions of type, or its subclasses.
+ * Later registrations take precedence. E must be constructible from a
+ * const char*. Register with the GIL held, before throwing.
+ * The table keeps a reference to type until unregister_exception(), or
+ * until an interpreter it started finalizes python.
+ */
+template<typename E> void register_exception(PyObject* type)
+{
+    details::add_registered(type, &details::throw_as<E>);
+}
+
+/** remove the registrations of type, with the GIL held.
+ */
+inline void unregister_exception(PyObject* type)
+{
+    auto& t = details::err_table();
+    for(size_t i = details::err_builtins(); i < t.size();){
+        if(t[i].first == type){
+            Py_DECREF(type);
+            t.erase(t.begin() + i);
+        }
+        else
+            i++;
+    }
+}
+
+/** throw the err registered for the pending python error, err if none matches.
+ * The python error stays set, and is captured by the err.
+ * Calls and item access throw through it, so what they throw follows the
+ * python exception: e.g. type_err only for a TypeError, key_err for a
+ * KeyError, and a plain err for a RuntimeError or an unregistered type.
+ */
+[[noreturn]] inline void throw_current(const char* what)
+{
+    PyObject* t = PyErr_Occurred();
+    if(t){
+        auto& table = details::err_table();
+        for(auto i = table.rbegin(); i != table.rend(); ++i){
+            if(PyErr_GivenExceptionMatches(t, i->first))
+                i->second(what);
+        }
+    }
+    throw err(what);
+}
+
+
+/* non-throwing results
+**********************/
+
+/** what try_ methods do with the python error of a failure.
+ */
+enum class err_policy{
+    clear,  ///< PyErr_Clear, the default
+    keep    ///< leave it set, for print_err or the caller
+};
+
+/** kind of a failure, from the python exception.
+ */
+enum class err_kind{ none, index, key, attr, type, val, io, other };
+
+/** failure of a try_ method, a cheap value instead of a thrown err.
+ */
+class error{
+private:
+    err_kind _kind;
+    const char* _what;
+
+public:
+    error():_kind(err_kind::none), _what(NULL)
+    {}
+
+    error(err_kind kind, const char* what):_kind(kind), _what(what)
+    {}
+
+    err_kind kind()const
+    {
+        return _kind;
+    }
+
+    const char* what()const
+    {
+        return _what;
+    }
+
+    /** throw the err the throwing variant would throw.
+     * key and attr failures throw key_err and attr_err, both index_err.
+     */
+    [[noreturn]] void raise()const
+    {
+        switch(_kind){
+        case err_kind::index:
+            throw index_err(_what);
+        case err_kind::key:
+            throw key_err(_what);
+        case err_kind::attr:
+            throw attr_err(_what);
+        case err_kind::type:
+            throw type_err(_what);
+        case err_kind::val:
+            throw val_err(_what);
+        case err_kind::io:
+            throw io_err(_what);
+        default:
+            throw err(_what);
+        }
+    }
+};
+
+namespace details{
+
+/** error from the current python exception, cleared or kept as asked.
+ * @param miss  kind to use when no python exception is set
+ */
+inline error take_error(err_policy policy, const char* what, err_kind miss = err_kind::other)
+{
+    err_kind k = miss;
+    PyObject* t = PyErr_Occurred();
+    if(t){
+        if(PyErr_GivenExceptionMatches(t, PyExc_KeyError))
+            k = err_kind::key;
+        else if(PyErr_GivenExceptionMatches(t, PyExc_IndexError))
+            k = err_kind::index;
+        else if(PyErr_GivenExceptionMatches(t, PyExc_AttributeError))
+            k = err_kind::attr;
+        else if(PyErr_GivenExceptionMatches(t, PyExc_TypeError))
+            k = err_kind::type;
+        else if(PyErr_GivenExceptionMatches(t, PyExc_ValueError))
+            k = err_kind::val;
+        else if(PyErr_GivenExceptionMatches(t, PyExc_EnvironmentError))
+            k = err_kind::io;
+        else
+            k = err_kind::other;
+        if(policy == err_policy::clear)
+            PyErr_Clear();
+    }
+    return error(k, what);
+}
+
+}; // ns details
+
+/** a value, or the error why there is none.
+ * Returned by the try_ methods, which don't throw on failure.
+ */
+template<typename T> class expected{
+private:
+    T _val;
+    py::error _err;
+
+public:
+    expected(const T& v):_val(v)
+    {}
+
+    expected(T&& v):_val(std::move(v))
+    {}
+
+    /** no value, because of e.
+     * e must be a failure: an err_kind::none error is taken as err_kind::other.
+     */
+    expected(const py::error& e):_val(),
+        _err(e.kind() == err_kind::none ? py::error(err_kind::other, e.what()) : e)
+    {
+        assert(e.kind() != err_kind::none);
+    }
+
+    bool has_value()const
+    {
+        return _err.kind() == err_kind::none;
+    }
+
+    explicit operator bool()const
+    {
+        return has_value();
+    }
+
+    /** the value.
+     * @throw the error's err if there is none
+     */
+    T& value()
+    {
+        if(!has_value())
+            _err.raise();
+        return _val;
+    }
+
+    const T& value()const
+    {
+        if(!has_value())
+            _err.raise();
+        return _val;
+    }
+
+    /** the value, unchecked.
+     */
+    T& operator*()
+    {
+        return _val;
+    }
+
+    const T& operator*()const
+    {
+        return _val;
+    }
+
+    T* operator->()
+    {
+        return &_val;
+    }
+
+    const T* operator->()const
+    {
+        return &_val;
+    }
+
+    /** the value, or d if there is none.
+     */
+    template<typename U> T value_or(U&& d)const
+    {
+        return has_value() ? _val : T(std::forward<U>(d));
+    }
+
+    const py::error& error()const
+    {
+        return _err;
+    }
+};
+
 
 }; // ns py
@@ -0,0 +1,180 @@
+namespace py{
+
+/** LRU cache of compiled code objects.
+ * Keyed by source hash, filename and compile mode; the source is compared on a hit.
+ * Use it with the GIL held.
+ */
+class code_cache{
+private:
+    struct entry{
+        std::string src;
+        std::string filename;
+        int mode;
+        size_t key;
+        obj code;
+    };
+    typedef std::list<entry> lru_t;
+
+    size_t _capacity;
+    lru_t _lru;
+    std::unordered_multimap<size_t, lru_t::iterator> _map;
+    size_t _hits;
+    size_t _misses;
+
+    static size_t key_of(const char* src, const char* filename, int mode)
+    {
+        // FNV-1a
+        size_t h = 14695981039346656037ULL;
+        for(const char* p = src; *p; p++)
+            h = (h ^ (unsigned char)*p) * 1099511628211ULL;
+        h = (h ^ 0xff) * 1099511628211ULL;
+        for(const char* p = filename; *p; p++)
+            h = (h ^ (unsigned char)*p) * 1099511628211ULL;
+        return (h ^ (size_t)mode) * 1099511628211ULL;
+    }
+
+public:
+    explicit code_cache(size_t capacity = 256):_capacity(capacity), _hits(0), _misses(0)
+    {}
+
+    /** compile src, or get it from the cache.
+     * @param mode  Py_eval_input, Py_file_input or Py_single_input
+     * @throw val_err if compiling fails
+     */
+    obj compile(const char* src, const char* filename = "<string>", int mode = Py_eval_input)
+    {
+        size_t k = key_of(src, filename, mode);
+        auto r = _map.equal_range(k);
+        for(auto i = r.first; i != r.second; ++i){
+            entry& e = *i->second;
+            if(e.mode == mode && e.src == src && e.filename == filename){
+                _hits++;
+                _lru.splice(_lru.begin(), _lru, i->second);
+                return e.code;
+            }
+        }
+
+        _misses++;
+        obj code(Py_CompileString(src, filename, mode));
+        if(!code)
+            throw val_err("compile failed");
+        if(!_capacity)
+            return code;
+        if(_lru.size() >= _capacity){
+            entry& old = _lru.back();
+            auto o = _map.equal_range(old.key);
+            for(auto i = o.first; i != o.second; ++i){
+                if(&*i->second == &old){
+                    _map.erase(i);
+                    break;
+                }
+            }
+            _lru.pop_back();
+        }
+        entry e;
+        e.src = src;
+        e.filename = filename;
+        e.mode = mode;
+        e.key = k;
+        e.code = code;
+        _lru.push_front(std::move(e));
+        _map.insert(std::make_pair(k, _lru.begin()));
+        return code;
+    }
+
+    /** drop all cached code.
+     */
+    void clear()
+    {
+        _map.clear();
+        _lru.clear();
+    }
+
+    size_t size()const
+    {
+        return _lru.size();
+    }
+
+    size_t capacity()const
+    {
+        return _capacity;
+    }
+
+    size_t hits()const
+    {
+        return _hits;
+    }
+
+    size_t misses()const
+    {
+        return _misses;
+    }
+};
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+/** the code cache used by eval() and exec().
+ * It is cleared when the interpreter is finalized.
+ */
+inline code_cache& default_code_cache()
+{
+    static code_cache* c = NULL;
+    if(!c){
+        c = new code_cache();
+        details::fini_hooks().push_back([]{ default_code_cache().clear(); });
+    }
+    return *c;
+}
+
+namespace details{
+
+inline obj eval_code(const char* src, const char* filename, int mode, const obj& globals, const obj& locals)
+{
+    obj code = default_code_cache().compile(src, filename, mode);
+    obj g = globals;
+    if(!g)
+        g = PyDict_New();
+    if(PyDict_Check(g.p()) && !PyDict_GetItemString(g.p(), "__builtins__"))
+        PyDict_SetItemString(g.p(), "__builtins__", PyEval_GetBuiltins());
+    PyObject* r = PyEval_EvalCode((PyCodeObject*)code.p(), g.p(), !locals ? g.p() : locals.p());
+    if(!r)
+        throw_current("eval failed");
+    return r;
+}
+
+};
+
+/** evaluate a python expression.
+ * The compiled code is cached in default_code_cache().
+ * @param globals  a dict, __builtins__ is added if missing; if null, a new dict
+ * @param locals  a mapping; if null, globals
+ * @throw val_err if compiling fails
+ * @throw the err throw_current() maps the raised exception to
+ */
+inline obj eval(const char* expr, const obj& globals = obj(), const obj& locals = obj(),
+    const char* filename = "<string>")
+{
+    return details::eval_code(expr, filename, Py_eval_input, globals, locals);
+}
+
+/** execute python statements.
+ * The compiled code is cached in default_code_cache().
+ * @param globals  a dict, __builtins__ is added if missing; if null, a new dict
+ * @param locals  a mapping; if null, globals
+ * @throw val_err if compiling fails
+ * @throw the err throw_current() maps the raised exception to
+ */
+inline void exec(const char* code, const obj& globals = obj(), const obj& locals = obj(),
+    const char* filename = "<string>")
+{
+    details::eval_code(code, filename, Py_file_input, globals, locals);
+}
+
+/**
+ * @}
+ */
+
+}; // ns py
@@ -0,0 +1,302 @@
+namespace py{
+
+namespace details{
+
+/** work item of an executor.
+ */
+struct task_node{
+    task_node* next;
+
+    task_node():next(NULL)
+    {}
+
+    virtual ~task_node()
+    {}
+
+    /** run with the GIL held.
+     * Must not throw, and must drop any obj it holds before returning.
+     * A python error left set is printed as unraisable, then cleared.
+     */
+    virtual void run() = 0;
+
+    /** called after the batch, on the same thread, without the GIL.
+     */
+    virtual void complete()
+    {}
+};
+
+/** call f, throwing an err if it returns with a python error set.
+ */
+template<typename R> struct call_checked{
+    template<typename F> static R call(F& f)
+    {
+        R r = f();
+        if(PyErr_Occurred())
+            throw err("task left a python error set");
+        return r;
+    }
+};
+
+template<> struct call_checked<void>{
+    template<typename F> static void call(F& f)
+    {
+        f();
+        if(PyErr_Occurred())
+            throw err("task left a python error set");
+    }
+};
+
+template<typename R, typename F> struct future_node: public task_node{
+    std::unique_ptr<F> fn;
+    std::packaged_task<R()> task;
+
+    future_node(F&& f):fn(new F(std::move(f))), task([this]{ return call_checked<R>::call(*fn); })
+    {}
+
+    void run()
+    {
+        task();
+        // the future's err holds its own copy of a python error
+        PyErr_Clear();
+        // drop the callable and its captures here, with the GIL held;
+        // the shared state of the future only refers to it, and may hold an err
+        fn.reset();
+        task = std::packaged_task<R()>();
+    }
+};
+
+/** lock-free multi-producer single-consumer queue.
+ * Producers push onto a stack; the consumer takes all nodes at once, in FIFO order.
+ */
+class mpsc_queue{
+private:
+    std::atomic<task_node*> _head;
+public:
+    mpsc_queue():_head(NULL)
+    {}
+
+    /** push a node.
+     * @return true if the queue was empty
+     */
+    bool push(task_node* n)
+    {
+        task_node* h = _head.load(std::memory_order_relaxed);
+        do{
+            n->next = h;
+        }while(!_head.compare_exchange_weak(h, n, std::memory_order_release, std::memory_order_relaxed));
+        return h == NULL;
+    }
+
+    bool empty()const
+    {
+        return _head.load(std::memory_order_acquire) == NULL;
+    }
+
+    /** take all nodes, oldest first.
+     */
+    task_node* take_all()
+    {
+        task_node* h = _head.exchange(NULL, std::memory_order_acquire);
+        task_node* r = NULL;
+        while(h){
+            task_node* n = h->next;
+            h->next = r;
+            r = h;
+            h = n;
+        }
+        return r;
+    }
+};
+
+}; // ns details
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+/** run python work on one dedicated thread.
+ * Any thread can submit work without touching the GIL; the executor thread
+ * drains the queue in batches, each under a single GIL hold, and returns results
+ * through futures.
+ * If python is not initialized yet, the executor thread starts it and finalizes it
+ * at destruction. Otherwise python must have threads enabled and outlive the
+ * executor, and its owner must release the GIL (e.g. with gil_scoped_release)
+ * while waiting for results.
+ */
+class executor{
+public:
+    /** executor statistics.
+     */
+    struct stats_t{
+        /** submitted, but not completed.
+         */
+        size_t queue_depth;
+        size_t submitted;
+        size_t completed;
+        size_t batches;
+        size_t last_batch;
+        size_t max_batch;
+    };
+
+private:
+    details::mpsc_queue _q;
+    std::mutex _m;
+    std::condition_variable _cv;
+    bool _stop;
+    size_t _batch_limit;
+    init_options _opt;
+    std::atomic<size_t> _submitted;
+    std::atomic<size_t> _completed;
+    std::atomic<size_t> _batches;
+    std::atomic<size_t> _last_batch;
+    std::atomic<size_t> _max_batch;
+    std::thread _th;
+
+    void push(details::task_node* n)
+    {
+        _submitted.fetch_add(1, std::memory_order_relaxed);
+        if(_q.push(n)){
+            std::lock_guard<std::mutex> l(_m);
+            _cv.notify_one();
+        }
+    }
+
+    void run_batch(details::task_node* b, PyThreadState* ts)
+    {
+        size_t n = 0;
+        for(details::task_node* i = b; i; i = i->next)
+            n++;
+        _batches.fetch_add(1, std::memory_order_relaxed);
+        _last_batch.store(n, std::memory_order_relaxed);
+        if(n > _max_batch.load(std::memory_order_relaxed))
+            _max_batch.store(n, std::memory_order_relaxed);
+
+        details::task_node* i = b;
+        while(i){
+            PyEval_RestoreThread(ts);
+            for(size_t k = 0; i && (!_batch_limit || k < _batch_limit); k++, i = i->next){
+                i->run();
+                if(PyErr_Occurred())
+                    PyErr_WriteUnraisable(NULL);
+            }
+            drain_decrefs();
+            PyEval_SaveThread();
+        }
+        while(b){
+            details::task_node* next = b->next;
+            b->complete();
+            delete b;
+            _completed.fetch_add(1, std::memory_order_relaxed);
+            b = next;
+        }
+    }
+
+    void loop()
+    {
+        std::unique_ptr<interpreter> interp;
+        PyThreadState* ts = NULL;
+        PyGILState_STATE gs = PyGILState_UNLOCKED;
+        if(!Py_IsInitialized()){
+            _opt.init_threads = true;
+            interp.reset(new interpreter(_opt));
+            ts = PyEval_SaveThread();
+        }
+
+        while(1){
+            details::task_node* b = _q.take_all();
+            if(b){
+                if(!ts){
+                    // one thread state for the life of the worker, not one per batch
+                    gs = PyGILState_Ensure();
+                    ts = PyEval_SaveThread();
+                }
+                run_batch(b, ts);
+                continue;
+            }
+            std::unique_lock<std::mutex> l(_m);
+            if(_stop && _q.empty())
+                break;
+            _cv.wait(l, [this]{ return _stop || !_q.empty(); });
+        }
+
+        if(ts){
+            PyEval_RestoreThread(ts);
+            if(interp)
+                interp.reset();
+            else
+                PyGILState_Release(gs);
+        }
+    }
+
+public:
+    /** start the executor thread.
+     * @param opt  used if the executor starts python
+     * @param batch_limit  if not 0, release and take the GIL again every batch_limit items
+     */
+    explicit executor(const init_options& opt = init_options(), size_t batch_limit = 0)
+        :_stop(false), _batch_limit(batch_limit), _opt(opt), _submitted(0), _completed(0),
+        _batches(0), _last_batch(0), _max_batch(0)
+    {
+        _th = std::thread([this]{ loop(); });
+    }
+
+    executor(const executor&) = delete;
+    executor& operator=(const executor&) = delete;
+
+    /** run the remaining work, and stop the executor thread.
+     */
+    ~executor()
+    {
+        {
+            std::lock_guard<std::mutex> l(_m);
+            _stop = true;
+            _cv.notify_one();
+        }
+        if(gil_held()){
+            gil_scoped_release nogil;
+            _th.join();
+        }
+        else
+            _th.join();
+    }
+
+    /** submit f, to be called with the GIL held on the executor thread.
+     * Don't wait for the result from inside another task.
+     * @return the future result of f(); exceptions are passed through it, and
+     * so is a python error f returns with, as an err
+     */
+    template<typename F> std::future<decltype(std::declval<F&>()())> submit(F f)
+    {
+        typedef decltype(std::declval<F&>()()) R;
+        details::future_node<R, F>* n = new details::future_node<R, F>(std::move(f));
+        std::future<R> r = n->task.get_future();
+        push(n);
+        return r;
+    }
+
+    /** submit a work item; it is deleted after it completes.
+     */
+    void submit_node(details::task_node* n)
+    {
+        push(n);
+    }
+
+    stats_t stats()const
+    {
+        stats_t s;
+        s.submitted = _submitted.load(std::memory_order_relaxed);
+        s.completed = _completed.load(std::memory_order_relaxed);
+        s.queue_depth = s.submitted > s.completed ? s.submitted - s.completed : 0;
+        s.batches = _batches.load(std::memory_order_relaxed);
+        s.last_batch = _last_batch.load(std::memory_order_relaxed);
+        s.max_batch = _max_batch.load(std::memory_order_relaxed);
+        return s;
+    }
+};
+
+/**
+ * @}
+ */
+
+}; // ns py
@@ -1,19 +1,232 @@
 namespace py{
 
+namespace details{
+
+/** fread from a file object's FILE*, with the GIL released as python does.
+ * @throw io_err on a read error
+ */
+inline size_t file_read(PyObject* f, FILE* fp, void* p, size_t n)
+{
+    size_t r;
+    bool failed;
+    PyFile_IncUseCount((PyFileObject*)f);
+    Py_BEGIN_ALLOW_THREADS
+    r = fread(p, 1, n, fp);
+    failed = r < n && ferror(fp);
+    Py_END_ALLOW_THREADS
+    PyFile_DecUseCount((PyFileObject*)f);
+    if(failed){
+        clearerr(fp);
+        PyErr_SetFromErrno(PyExc_IOError);
+        throw io_err("read failed");
+    }
+    return r;
+}
+
+/** fwrite to a file object's FILE*, with the GIL released.
+ * @throw io_err
+ */
+inline void file_write(PyObject* f, FILE* fp, const void* p, size_t n)
+{
+    size_t r;
+    PyFile_IncUseCount((PyFileObject*)f);
+    Py_BEGIN_ALLOW_THREADS
+    r = fwrite(p, 1, n, fp);
+    Py_END_ALLOW_THREADS
+    PyFile_DecUseCount((PyFileObject*)f);
+    if(r < n){
+        clearerr(fp);
+        PyErr_SetFromErrno(PyExc_IOError);
+        throw io_err("write failed");
+    }
+}
+
+}; // ns details
+
+/** lines of a file, read in large blocks from its FILE*, see file::lines().
+ * The lines are str_views into an internal buffer, with their line end, valid
+ * until the next line is read; to_str() makes a python str only when needed.
+ * Lines end at '\n', or in universal newline mode also at '\r' and "\r\n",
+ * which are kept as they are in the file rather than translated.
+ * It reads the FILE* directly, so lines already buffered by python's file
+ * iteration are not seen. The GIL is released while reading blocks.
+ */
+class line_range{
+private:
+    obj _f;
+    FILE* _fp;
+    std::vector<char> _buf;
+    size_t _begin;
+    size_t _end;
+    bool _univ;
+    bool _eof;
+    bool _done;
+    str_view _line;
+
+    /** the first line end in [s, s + n), '\n', or also '\r' in universal newline mode.
+     */
+    const char* find_eol(const char* s, size_t n)const
+    {
+        if(!_univ)
+            return (const char*)memchr(s, '\n', n);
+        for(const char* e = s + n; s != e; s++){
+            if(*s == '\n' || *s == '\r')
+                return s;
+        }
+        return NULL;
+    }
+
+    /** move the partial line to the front, and read a block after it.
+     * @throw io_err
+     */
+    void fill()
+    {
+        size_t n = _end - _begin;
+        if(_begin)
+            memmove(_buf.data(), _buf.data() + _begin, n);
+        _begin = 0;
+        _end = n;
+        if(_end == _buf.size())
+            _buf.resize(_buf.size() * 2);
+        size_t r = details::file_read(_f.p(), _fp, _buf.data() + _end, _buf.size() - _end);
+        _end += r;
+        if(r == 0)
+            _eof = true;
+    }
+
+public:
+    class iterator{
+    private:
+        line_range* _r;
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef str_view value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const str_view* pointer;
+        typedef const str_view& reference;
+
+        iterator(line_range* r):_r(r)
+        {}
+
+        const str_view& operator*()const
+        {
+            return _r->_line;
+        }
+
+        const str_view* operator->()const
+        {
+            return &_r->_line;
+        }
+
+        /** @throw io_err
+         */
+        iterator& operator++()
+        {
+            if(!_r->next())
+                _r = NULL;
+            return *this;
+        }
+
+        bool operator==(const iterator& i)const
+        {
+            return _r == i._r;
+        }
+
+        bool operator!=(const iterator& i)const
+        {
+            return _r != i._r;
+        }
+    };
+
+    /** @throw io_err if f is not an open file
+     */
+    line_range(const obj& f, size_t block):_f(f), _fp(PyFile_AsFile(f.p())),
+        _buf(block ? block : 1), _begin(0), _end(0), _univ(false), _eof(false), _done(false)
+    {
+        if(!_fp)
+            throw io_err("file not open");
+        _univ = ((PyFileObject*)f.p())->f_univ_newline != 0;
+    }
+
+    line_range(line_range&& o):_f(std::move(o._f)), _fp(o._fp), _buf(std::move(o._buf)),
+        _begin(o._begin), _end(o._end), _univ(o._univ), _eof(o._eof), _done(o._done), _line(o._line)
+    {
+        o._fp = NULL;
+    }
+
+    line_range(const line_range&) = delete;
+    line_range& operator=(const line_range&) = delete;
+
+    /** seek the FILE* back over the bytes read ahead but not returned,
+     * so that reading goes on after the last line returned.
+     * This fails silently on pipes and other unseekable files.
+     */
+    ~line_range()
+    {
+        if(_fp && _end > _begin)
+            fseek(_fp, -(long)(_end - _begin), SEEK_CUR);
+    }
+
+    /** read the next line.
+     * @return false at the end of the file
+     * @throw io_err
+     */
+    bool next()
+    {
+        while(!_done){
+            const char* s = _buf.data() + _begin;
+            const char* last = _buf.data() + _end;
+            const char* e = find_eol(s, _end - _begin);
+            if(e && *e == '\r'){
+                if(e + 1 < last && e[1] == '\n')
+                    e++;
+                else if(e + 1 == last && !_eof)
+                    e = NULL; // a '\n' may start the next block
+            }
+            if(e){
+                _line = str_view(s, e + 1 - s);
+                _begin += _line.size();
+                return true;
+            }
+            if(_eof){
+                _done = true;
+                _line = str_view(s, _end - _begin);
+                _begin = _end;
+                return !_line.empty();
+            }
+            fill();
+        }
+        return false;
+    }
+
+    /** read the first line.
+     * @throw io_err
+     */
+    iterator begin()
+    {
+        return next() ? iterator(this) : end();
+    }
+
+    iterator end()
+    {
+        return iterator(NULL);
+    }
+};
+
 /** file object
  */
 
 class file: public obj{
 protected:
-    void type_check(PyObject* p)noexcept(!PY11_ENFORCE)
+    void type_check(PyObject* p)noexcept(!PY11_ENFORCE_FILE)
     {
-        if(PY11_ENFORCE && p){
-            if(!PyFile_Check(p))
+        if(PY11_ENFORCE_FILE && p && !PyFile_CheckExact(p)){
+            if(PY11_ENFORCE_FILE >= 2 || !PyFile_Check(p))
                 throw type_err("file ctor failed");
         }
     }
     
-    void type_check(const obj& o)noexcept(!PY11_ENFORCE)
+    void type_check(const obj& o)noexcept(!PY11_ENFORCE_FILE)
     {
         type_check((PyObject*)o.p());
     }
@@ -22,6 +235,11 @@ public:
     /** ctor.
      */
     file()=default;
+
+    /** take a new reference known to be a file, without checking.
+     */
+    file(PyObject* p, unchecked_t)noexcept:obj(p)
+    {}
             
     file(const obj& o)
     {
@@ -39,13 +257,13 @@ public:
         return *this;
     }
 
-    file(obj&& o)noexcept(!PY11_ENFORCE)
+    file(obj&& o)noexcept(!PY11_ENFORCE_FILE)
     {
         type_check(o);
         _p = o.transfer();
     }
     
-    file& operator=(obj&& o)noexcept(!PY11_ENFORCE)
+    file& operator=(obj&& o)noexcept(!PY11_ENFORCE_FILE)
     {
         if(o.p()!=_p){
             type_check(o);
@@ -102,6 +320,85 @@ public:
         return r;
     }
     
+    /** iterate lines read in blocks, without making python objects.
+     * The range reads ahead, and seeks back when destroyed: read other
+     * data only once it is gone, and not at all from an unseekable file.
+     * @param block  initial buffer size, it grows for longer lines
+     * @throw io_err
+     */
+    line_range lines(size_t block = 1 << 16)const
+    {
+        return line_range(*this, block);
+    }
+
+    /** read up to n bytes into p, from the FILE* without a python string.
+     * Like lines(), it doesn't see data buffered by python's file iteration.
+     * @return bytes read, less than n only at the end of the file
+     * @throw io_err
+     */
+    size_t read_into(void* p, size_t n)
+    {
+        FILE* fp = PyFile_AsFile(_p);
+        if(!fp)
+            throw io_err("file not open");
+        return details::file_read(_p, fp, p, n);
+    }
+
+    /** read into a writable python buffer, such as a bytearray.
+     * @return bytes read, less than its size only at the end of the file
+     * @throw type_err if target isn't a writable buffer
+     * @throw io_err
+     */
+    size_t read_into(const obj& target)
+    {
+        Py_buffer b;
+        if(PyObject_GetBuffer(target.p(), &b, PyBUF_WRITABLE) == -1)
+            throw type_err("read_into needs a writable buffer");
+        try{
+            size_t r = read_into(b.buf, b.len);
+            PyBuffer_Release(&b);
+            return r;
+        }
+        catch(...){
+            PyBuffer_Release(&b);
+            throw;
+        }
+    }
+
+    /** read exactly n bytes into p.
+     * @throw eof_err if the file ends first
+     * @throw io_err
+     */
+    void read_exact(void* p, size_t n)
+    {
+        if(read_into(p, n) < n)
+            throw eof_err("read_exact hit the end of file");
+    }
+
+    /** fill a writable python buffer.
+     * @throw eof_err if the file ends first
+     * @throw type_err
+     * @throw io_err
+     */
+    void read_exact(const obj& target)
+    {
+        Py_buffer b;
+        if(PyObject_GetBuffer(target.p(), &b, PyBUF_WRITABLE) == -1)
+            throw type_err("read_exact needs a writable buffer");
+        size_t r;
+        try{
+            r = read_into(b.buf, b.len);
+        }
+        catch(...){
+            PyBuffer_Release(&b);
+            throw;
+        }
+        size_t n = b.len;
+        PyBuffer_Release(&b);
+        if(r < n)
+            throw eof_err("read_exact hit the end of file");
+    }
+
     /** get the filename
      */
     str filename()const
@@ -132,5 +429,274 @@ public:
     }
 };
 
+/** buffered writer to a file's FILE*.
+ * Writes are collected in a c++ buffer, numbers are formatted natively, and
+ * the buffer goes to the file in large chunks, with the GIL released.
+ * Use it with the GIL held; it flushes when destroyed, ignoring errors.
+ */
+class file_writer{
+private:
+    file _f;
+    FILE* _fp;
+    std::vector<char> _buf;
+    size_t _n;
+
+    void put(const char* s, size_t n)
+    {
+        if(_n + n > _buf.size()){
+            drain();
+            if(n >= _buf.size()){
+                write_out(s, n);
+                return;
+            }
+        }
+        memcpy(_buf.data() + _n, s, n);
+        _n += n;
+    }
+
+    void write_out(const char* s, size_t n)
+    {
+        details::file_write(_f.p(), _fp, s, n);
+    }
+
+    void drain()
+    {
+        size_t n = _n;
+        _n = 0;
+        if(n)
+            write_out(_buf.data(), n);
+    }
+
+public:
+    /** @param capacity  buffer size, larger writes bypass it
+     * @throw io_err if f is not an open file
+     */
+    explicit file_writer(const file& f, size_t capacity = 1 << 16)
+        :_f(f), _fp(PyFile_AsFile(f.p())), _buf(capacity ? capacity : 1), _n(0)
+    {
+        if(!_fp)
+            throw io_err("file not open");
+    }
+
+    file_writer(const file_writer&) = delete;
+    file_writer& operator=(const file_writer&) = delete;
+
+    ~file_writer()
+    {
+        try{
+            flush();
+        }
+        catch(const err&){
+            PyErr_Clear();
+        }
+    }
+
+    /** bytes waiting in the buffer.
+     */
+    size_t pending()const
+    {
+        return _n;
+    }
+
+    /** @throw io_err
+     */
+    file_writer& write(str_view s)
+    {
+        put(s.data(), s.size());
+        return *this;
+    }
+
+    file_writer& write(const char* s)
+    {
+        put(s, strlen(s));
+        return *this;
+    }
+
+    file_writer& write(const std::string& s)
+    {
+        put(s.data(), s.size());
+        return *this;
+    }
+
+    file_writer& write(char c)
+    {
+        put(&c, 1);
+        return *this;
+    }
+
+    /** write True or False, as python does.
+     */
+    file_writer& write(bool v)
+    {
+        return v ? write("True") : write("False");
+    }
+
+    /** write an integer in decimal.
+     */
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value, file_writer&>::type write(T v)
+    {
+        char s[24];
+        int n = std::is_signed<T>::value
+            ? snprintf(s, sizeof(s), "%lld", (long long)v)
+            : snprintf(s, sizeof(s), "%llu", (unsigned long long)v);
+        put(s, n);
+        return *this;
+    }
+
+    /** write a float with the fewest digits that read back the same,
+     * and ".0" after an integral value, as python does.
+     */
+    file_writer& write(double v)
+    {
+        char s[40];
+        int n = 0;
+        for(int prec = 15; prec <= 17; prec++){
+            n = snprintf(s, sizeof(s), "%.*g", prec, v);
+            if(strtod(s, NULL) == v)
+                break;
+        }
+        if(!strpbrk(s, ".en")){
+            memcpy(s + n, ".0", 3);
+            n += 2;
+        }
+        put(s, n);
+        return *this;
+    }
+
+    /** write str(o); str objects are copied directly.
+     * @throw val_err if str() fails
+     */
+    file_writer& write(const obj& o)
+    {
+        if(PyString_CheckExact(o.p())){
+            put(PyString_AS_STRING(o.p()), PyString_GET_SIZE(o.p()));
+            return *this;
+        }
+        obj t = o.to_str();
+        put(PyString_AS_STRING(t.p()), PyString_GET_SIZE(t.p()));
+        return *this;
+    }
+
+    template<typename T> file_writer& operator<<(const T& v)
+    {
+        return write(v);
+    }
+
+    /** write each element, adding nothing between them, as file.writelines.
+     */
+    template<typename It> file_writer& writelines(It first, It last)
+    {
+        for(; first != last; ++first)
+            write(*first);
+        return *this;
+    }
+
+    template<typename R> file_writer& writelines(const R& r)
+    {
+        return writelines(std::begin(r), std::end(r));
+    }
+
+    /** write the buffer out, and flush the FILE*.
+     * @throw io_err
+     */
+    void flush()
+    {
+        drain();
+        if(fflush(_fp) != 0){
+            PyErr_SetFromErrno(PyExc_IOError);
+            throw io_err("flush failed");
+        }
+    }
+};
+
+/** reusable fixed-size byte buffers, for read_into loops.
+ * acquire() takes a free buffer or allocates one; a buffer goes back to the
+ * pool when destroyed, up to max_free of them are kept. It is thread safe,
+ * and the pool must outlive its buffers.
+ */
+class buffer_pool{
+private:
+    size_t _size;
+    size_t _max_free;
+    std::vector<std::unique_ptr<char[]>> _free;
+    std::mutex _m;
+
+    void give_back(std::unique_ptr<char[]> p)
+    {
+        std::lock_guard<std::mutex> l(_m);
+        if(_free.size() < _max_free)
+            _free.push_back(std::move(p));
+    }
+
+public:
+    /** a buffer of the pool, move only.
+     */
+    class buffer{
+    private:
+        buffer_pool* _pool;
+        std::unique_ptr<char[]> _p;
+
+    public:
+        buffer(buffer_pool* pool, std::unique_ptr<char[]> p):_pool(pool), _p(std::move(p))
+        {}
+
+        buffer(buffer&& b)noexcept:_pool(b._pool), _p(std::move(b._p))
+        {}
+
+        buffer& operator=(buffer&& b)noexcept
+        {
+            if(this != &b){
+                if(_p)
+                    _pool->give_back(std::move(_p));
+                _pool = b._pool;
+                _p = std::move(b._p);
+            }
+            return *this;
+        }
+
+        ~buffer()
+        {
+            if(_p)
+                _pool->give_back(std::move(_p));
+        }
+
+        char* data()const
+        {
+            return _p.get();
+        }
+
+        size_t size()const
+        {
+            return _p ? _pool->block_size() : 0;
+        }
+    };
+
+    explicit buffer_pool(size_t block_size, size_t max_free = 16)
+        :_size(block_size), _max_free(max_free)
+    {}
+
+    buffer_pool(const buffer_pool&) = delete;
+    buffer_pool& operator=(const buffer_pool&) = delete;
+
+    size_t block_size()const
+    {
+        return _size;
+    }
+
+    buffer acquire()
+    {
+        {
+            std::lock_guard<std::mutex> l(_m);
+            if(!_free.empty()){
+                std::unique_ptr<char[]> p = std::move(_free.back());
+                _free.pop_back();
+                return buffer(this, std::move(p));
+            }
+        }
+        return buffer(this, std::unique_ptr<char[]>(new char[_size]));
+    }
+};
+
 }; // ns py
 
@@ -0,0 +1,199 @@
+#ifndef _WIN32
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace py{
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+namespace details{
+
+/** raise the threshold of the oldest generation out of reach, unless gc.freeze() exists.
+ * @return the previous threshold, or a null obj
+ * @throw err
+ */
+inline obj hold_gc_threshold()
+{
+    obj gc = import("gc");
+    if(gc.has_attr("freeze"))
+        return obj();
+    obj th = gc.a("get_threshold")();
+    gc.a("set_threshold")(th[0], th[1], std::numeric_limits<int>::max());
+    return th;
+}
+
+}; // ns details
+
+/** keep the current heap away from the cyclic GC, so that forked processes
+ * share its pages instead of copying them when the GC walks them.
+ * Uses gc.freeze() where available (python 3.7+). Otherwise, collects once,
+ * and raises the threshold of the oldest generation so that full collections,
+ * the only ones reaching long-lived objects, practically stop.
+ * @return the previous threshold, to pass to thaw_heap() in the parent
+ * once the workers are forked, or a null obj with gc.freeze()
+ * @throw err
+ */
+inline obj freeze_heap()
+{
+    obj gc = import("gc");
+    gc.a("collect")();
+    if(gc.has_attr("freeze")){
+        gc.a("freeze")();
+        return obj();
+    }
+    return details::hold_gc_threshold();
+}
+
+/** restore a threshold returned by freeze_heap(), does nothing for a null obj.
+ * @throw err
+ */
+inline void thaw_heap(const obj& threshold)
+{
+    if(threshold.p())
+        import("gc").a("set_threshold")(threshold[0], threshold[1], threshold[2]);
+}
+
+/** fork server start-up options.
+ */
+struct fork_options{
+    /** modules preloaded before forking, parent packages first.
+     */
+    std::vector<std::string> modules;
+
+    /** call freeze_heap() before the first fork.
+     * Workers keep the raised threshold, the server restores its own.
+     */
+    bool freeze_gc;
+
+    /** disable the cyclic GC in workers.
+     */
+    bool disable_gc;
+
+    fork_options():freeze_gc(true), disable_gc(false)
+    {}
+};
+
+/** pre-fork server.
+ * One warmed interpreter imports the configured modules once,
+ * then forks workers on demand; each worker starts in milliseconds,
+ * sharing the warmed heap copy-on-write.
+ * Use it with the GIL held, from a process without other threads running python.
+ */
+class fork_server{
+private:
+    fork_options _opt;
+    std::vector<pid_t> _children;
+    std::vector<import_timing> _times;
+
+public:
+    /** import the modules, and freeze the heap.
+     * @throw val_err if an import fails
+     */
+    explicit fork_server(const fork_options& opt = fork_options()):_opt(opt)
+    {
+        _times = preload(_opt.modules, true);
+        if(_opt.freeze_gc)
+            thaw_heap(freeze_heap());
+    }
+
+    fork_server(const fork_server&) = delete;
+    fork_server& operator=(const fork_server&) = delete;
+
+    /** wait for the remaining workers.
+     */
+    ~fork_server()
+    {
+        wait_all();
+    }
+
+    /** fork a worker running f.
+     * The worker exits with f's return code, or 1 if f throws.
+     * @return pid of the worker
+     * @throw io_err
+     */
+    pid_t spawn(std::function<int()> f)
+    {
+        obj th;
+        if(_opt.freeze_gc)
+            th = details::hold_gc_threshold();
+        fflush(NULL);
+        pid_t pid = fork();
+        if(pid != 0)
+            thaw_heap(th);
+        if(pid == -1)
+            throw io_err("fork failed");
+        if(pid == 0){
+            // the child must never return or unwind into the caller
+            PyOS_AfterFork();
+            int r = 1;
+            try{
+                if(_opt.disable_gc)
+                    import("gc").a("disable")();
+                r = f();
+            }
+            catch(const std::exception& e){
+                std::cerr << "worker failed: " << e.what() << std::endl;
+                print_err();
+            }
+            catch(...){
+                std::cerr << "worker failed: unknown exception" << std::endl;
+            }
+            fflush(NULL);
+            _exit(r);
+        }
+        _children.push_back(pid);
+        return pid;
+    }
+
+    /** wait for a worker.
+     * @return its exit code, or -1 if it was killed or can't be waited for
+     */
+    int wait(pid_t pid)
+    {
+        int st = 0;
+        pid_t r;
+        {
+            gil_scoped_release nogil;
+            while((r = waitpid(pid, &st, 0)) == -1 && errno == EINTR)
+                ;
+        }
+        _children.erase(std::remove(_children.begin(), _children.end(), pid), _children.end());
+        if(r == -1)
+            return -1;
+        return WIFEXITED(st) ? WEXITSTATUS(st) : -1;
+    }
+
+    /** wait for all workers.
+     */
+    void wait_all()
+    {
+        while(!_children.empty())
+            wait(_children.back());
+    }
+
+    /** import time of each preloaded module.
+     */
+    const std::vector<import_timing>& import_times()const
+    {
+        return _times;
+    }
+
+    /** pids of running workers.
+     */
+    const std::vector<pid_t>& children()const
+    {
+        return _children;
+    }
+};
+
+/**
+ * @}
+ */
+
+}; // ns py
+
+#endif // _WIN32
@@ -0,0 +1,146 @@
+#include <marshal.h>
+
+namespace py{
+
+/** a module compiled into the binary, see tools/py11_freeze.py.
+ */
+struct frozen_module{
+    /** full dotted name.
+     */
+    const char* name;
+
+    /** marshaled code object.
+     */
+    const unsigned char* code;
+    size_t size;
+    bool is_package;
+};
+
+namespace details{
+
+inline std::unordered_map<std::string, const frozen_module*>& frozen_table()
+{
+    static std::unordered_map<std::string, const frozen_module*> t;
+    return t;
+}
+
+/** the importer module in sys.meta_path, NULL until installed.
+ * It is forgotten when the interpreter is finalized.
+ */
+inline PyObject*& frozen_importer()
+{
+    static PyObject* m = NULL;
+    static bool hooked = false;
+    if(!hooked){
+        hooked = true;
+        fini_hooks().push_back([]{ frozen_importer() = NULL; });
+    }
+    return m;
+}
+
+inline const frozen_module* find_frozen(const char* name)
+{
+    auto& t = frozen_table();
+    auto i = t.find(name);
+    return i == t.end() ? NULL : i->second;
+}
+
+/** find_module(fullname, path=None)
+ */
+inline PyObject* frozen_find_module(PyObject*, PyObject* args)
+{
+    const char* name;
+    PyObject* path = NULL;
+    if(!PyArg_ParseTuple(args, "s|O:find_module", &name, &path))
+        return NULL;
+    PyObject* r = find_frozen(name) ? frozen_importer() : Py_None;
+    Py_INCREF(r);
+    return r;
+}
+
+/** load_module(fullname)
+ */
+inline PyObject* frozen_load_module(PyObject*, PyObject* args)
+{
+    const char* name;
+    if(!PyArg_ParseTuple(args, "s:load_module", &name))
+        return NULL;
+    PyObject* m = PyDict_GetItemString(PyImport_GetModuleDict(), name);
+    if(m){
+        Py_INCREF(m);
+        return m;
+    }
+    const frozen_module* f = find_frozen(name);
+    if(!f){
+        PyErr_Format(PyExc_ImportError, "no frozen module %.200s", name);
+        return NULL;
+    }
+    obj code(PyMarshal_ReadObjectFromString((char*)f->code, f->size));
+    if(!code)
+        return NULL;
+    if(!PyCode_Check(code.p())){
+        PyErr_Format(PyExc_ImportError, "bad frozen module %.200s", name);
+        return NULL;
+    }
+    m = PyImport_AddModule(name);
+    if(!m)
+        return NULL;
+    if(PyModule_AddObject(m, "__loader__", obj(frozen_importer(), true).transfer()) == -1)
+        return NULL;
+    if(f->is_package){
+        obj path(Py_BuildValue("[s]", name));
+        if(!path || PyModule_AddObject(m, "__path__", path.transfer()) == -1)
+            return NULL;
+    }
+    char* file = PyString_AsString(((PyCodeObject*)code.p())->co_filename);
+    return PyImport_ExecCodeModuleEx((char*)name, code.p(), file);
+}
+
+};
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+/** make frozen modules importable, without any file system access.
+ * An importer is added to sys.meta_path on the first call, so py::import and
+ * python's import statement find these modules before searching sys.path.
+ * The modules must stay valid, and be compiled by the same python version.
+ * @param magic  the bytecode magic number of the compiling python
+ * @throw val_err if magic doesn't match this python
+ */
+inline void install_frozen(const frozen_module* mods, size_t n, long magic)
+{
+    if(magic != PyImport_GetMagicNumber())
+        throw val_err("frozen modules compiled by another python version");
+    for(size_t i = 0; i < n; i++)
+        details::frozen_table()[mods[i].name] = &mods[i];
+
+    PyObject*& imp = details::frozen_importer();
+    if(imp)
+        return;
+    static PyMethodDef methods[] = {
+        {"find_module", details::frozen_find_module, METH_VARARGS, NULL},
+        {"load_module", details::frozen_load_module, METH_VARARGS, NULL},
+        {NULL, NULL, 0, NULL}
+    };
+    imp = Py_InitModule4("_py11_frozen", methods, NULL, NULL, PYTHON_API_VERSION);
+    PyObject* meta = PySys_GetObject((char*)"meta_path");
+    if(!imp || !meta || PyList_Insert(meta, 0, imp) == -1)
+        throw val_err("install_frozen failed");
+}
+
+/** make a bundle generated by tools/py11_freeze.py importable.
+ * @throw val_err
+ */
+template<size_t N> void install_frozen(const frozen_module (&mods)[N], long magic)
+{
+    install_frozen(mods, N, magic);
+}
+
+/**
+ * @}
+ */
+
+}; // ns py
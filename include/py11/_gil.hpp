@@ -0,0 +1,56 @@
+namespace py{
+
+/* GIL management
+****************/
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+/** hold the GIL in the current scope.
+ * Usable from any thread, including threads not created by python,
+ * once threads are enabled (see init_options::init_threads).
+ */
+class gil_scoped_acquire{
+private:
+    PyGILState_STATE _s;
+public:
+    gil_scoped_acquire():_s(PyGILState_Ensure())
+    {}
+
+    gil_scoped_acquire(const gil_scoped_acquire&) = delete;
+    gil_scoped_acquire& operator=(const gil_scoped_acquire&) = delete;
+
+    ~gil_scoped_acquire()
+    {
+        drain_decrefs();
+        PyGILState_Release(_s);
+    }
+};
+
+/** release the GIL in the current scope, and take it back at scope exit.
+ * No obj may be used inside the scope.
+ */
+class gil_scoped_release{
+private:
+    PyThreadState* _s;
+public:
+    gil_scoped_release():_s(PyEval_SaveThread())
+    {}
+
+    gil_scoped_release(const gil_scoped_release&) = delete;
+    gil_scoped_release& operator=(const gil_scoped_release&) = delete;
+
+    ~gil_scoped_release()
+    {
+        PyEval_RestoreThread(_s);
+        drain_decrefs();
+    }
+};
+
+/**
+ * @}
+ */
+
+}; // ns py
@@ -22,12 +22,17 @@ public:
     }
     
     /** operator ++.
+     * @throw the err registered for an error raised by the iterator
      */
     iter& operator++()
     {
+        PY11_ASSERT_GIL();
         _v = obj(PyIter_Next(_it.p()));
-        if(!_v)
+        if(!_v){
             _fin = true;
+            if(PyErr_Occurred())
+                throw_current("iteration failed");
+        }
         return *this;
     }
     
@@ -1,18 +1,72 @@
 namespace py{
 
+namespace details{
+
+/** run f on a new thread, or right here if no thread can be started.
+ */
+template<typename F> void spawn_or_run(std::vector<std::thread>& ts, F f)
+{
+    try{
+        ts.emplace_back(f);
+    }
+    catch(...){
+        f();
+    }
+}
+
+/** stable sort, split over hardware threads for large ranges.
+ * cmp must not call into python, nor throw.
+ */
+template<typename It, typename Cmp> void parallel_stable_sort(It first, It last, Cmp cmp)
+{
+    const size_t min_chunk = 1 << 14;
+    size_t n = last - first;
+    size_t k = 1;
+    size_t t = std::thread::hardware_concurrency();
+    while(k * 2 <= t && n / (k * 2) >= min_chunk)
+        k *= 2;
+    if(k == 1){
+        std::stable_sort(first, last, cmp);
+        return;
+    }
+
+    std::vector<It> b(k + 1);
+    for(size_t c = 0; c <= k; c++)
+        b[c] = first + n * c / k;
+
+    std::vector<std::thread> ts;
+    ts.reserve(k);
+    for(size_t c = 1; c < k; c++)
+        spawn_or_run(ts, [&b, &cmp, c]{ std::stable_sort(b[c], b[c + 1], cmp); });
+    std::stable_sort(b[0], b[1], cmp);
+    for(auto& x: ts)
+        x.join();
+
+    for(size_t w = 1; w < k; w *= 2){
+        ts.clear();
+        for(size_t c = 2 * w; c < k; c += 2 * w)
+            spawn_or_run(ts, [&b, &cmp, c, w]{ std::inplace_merge(b[c], b[c + w], b[c + 2 * w], cmp); });
+        std::inplace_merge(b[0], b[w], b[2 * w], cmp);
+        for(auto& x: ts)
+            x.join();
+    }
+}
+
+}; // ns details
+
 /** py list.
  */
 class list: public seq{
 protected:
-    void type_check(PyObject* p)noexcept(!PY11_ENFORCE)
+    void type_check(PyObject* p)noexcept(!PY11_ENFORCE_LIST)
     {
-        if(PY11_ENFORCE && p){
-            if(!PyList_Check(p))
+        if(PY11_ENFORCE_LIST && p && !PyList_CheckExact(p)){
+            if(PY11_ENFORCE_LIST >= 2 || !PyList_Check(p))
                 throw type_err("creating list failed");
         }
     }
     
-    void type_check(const obj& o)noexcept(!PY11_ENFORCE)
+    void type_check(const obj& o)noexcept(!PY11_ENFORCE_LIST)
     {
         type_check((PyObject*)o.p());
     }
@@ -21,14 +75,19 @@ public:
     /** ctor.
      */
     list()=default;
+
+    /** take a new reference known to be a list, without checking.
+     */
+    list(PyObject* p, unchecked_t)noexcept:seq(p, unchecked)
+    {}
     
-    list(const obj& o)noexcept(!PY11_ENFORCE)
+    list(const obj& o)noexcept(!PY11_ENFORCE_LIST)
     {
         type_check(o);
         enter(o.p());
     }
     
-    list& operator=(const obj& o)noexcept(!PY11_ENFORCE)
+    list& operator=(const obj& o)noexcept(!PY11_ENFORCE_LIST)
     {
         if(o.p()!=_p){
             type_check(o);
@@ -38,13 +97,13 @@ public:
         return *this;
     }
 
-    list(obj&& o)noexcept(!PY11_ENFORCE)
+    list(obj&& o)noexcept(!PY11_ENFORCE_LIST)
     {
         type_check(o);
         _p = o.transfer();
     }
     
-    list& operator=(obj&& o)noexcept(!PY11_ENFORCE)
+    list& operator=(obj&& o)noexcept(!PY11_ENFORCE_LIST)
     {
         if(o.p()!=_p){
             type_check(o);
@@ -156,43 +215,62 @@ public:
     {
         PyObject* r = PyList_AsTuple(_p);
         if(r)
-            return r;
+            return tuple(r, unchecked);
         throw type_err("to_tuple failed");
     }
 
     /** get item.
      * Warning, a new obj will be got! not a reference to the original one!
-     * @throw index_err
+     * @throw the err throw_current() maps the raised exception to, index_err for an IndexError
      */
     const obj operator [](Py_ssize_t i)const
     {
         PyObject* p = PyList_GetItem(_p, i);
         if(!p){
-            throw index_err("non-existing item");
+            throw_current("non-existing item");
         }
-        return p;
+        return obj(p, true);
     }
     
     /** set_item.
-     * @throw index_err
+     * @throw the err throw_current() maps the raised exception to, index_err for an IndexError
      */
     void set_item(Py_ssize_t i, const obj& value)
     {
         int r = PyList_SetItem(_p, i, value.p());
         if(r == -1)
-            throw index_err("set_item failed");
+            throw_current("set_item failed");
     }
         
     /** slice, [i:j].
      * @throw type_err
      */
-    obj sub(int i, int j = std::numeric_limits<int>::max())const
+    obj sub(Py_ssize_t i, Py_ssize_t j = PY_SSIZE_T_MAX)const
     {
         PyObject* p = PyList_GetSlice(_p, i, j);
         if(!p)
             throw type_err("sub failed");
         return p;
     }
+
+    /** extended slice, [i:j:step].
+     * @throw val_err if step is 0
+     * @throw type_err
+     */
+    obj sub(Py_ssize_t i, Py_ssize_t j, Py_ssize_t step)const
+    {
+        return details::get_slice(_p, i, j, step);
+    }
+
+    /** view of [i:j:step] without copying, yielding borrowed items.
+     * @throw val_err if step is 0, or for a null list
+     */
+    slice_view<PyObject*> view(Py_ssize_t i = 0, Py_ssize_t j = PY_SSIZE_T_MAX, Py_ssize_t step = 1)const
+    {
+        if(!_p)
+            throw val_err("view of a null list");
+        return slice_view<PyObject*>(*this, PySequence_Fast_ITEMS(_p), PyList_GET_SIZE(_p), i, j, step);
+    }
     
     /** sort in place.
      */
@@ -203,6 +281,62 @@ public:
             throw err("sort failed");
     }
 
+    /** sort in place by a native key.
+     * key_fn(const obj&) is called once per item, and returns a c++ key
+     * with operator <, e.g. long, double, str_view or std::tuple of those.
+     * Keys are then sorted natively with the GIL released, in parallel for
+     * large lists, and items are rearranged in place. The sort is stable.
+     * The items are held meanwhile, so str_view keys stay valid.
+     * @throw val_err for a null list
+     * @throw err if the list is modified by key_fn or another thread
+     */
+    template<typename F> void sort_by(F key_fn, bool reverse = false)
+    {
+        typedef typename std::decay<decltype(key_fn(std::declval<const obj&>()))>::type key_t;
+        if(!_p)
+            throw val_err("sort_by on a null list");
+        Py_ssize_t n = PyList_GET_SIZE(_p);
+        std::vector<key_t> keys;
+        keys.reserve(n);
+        for(Py_ssize_t i = 0; i < n; i++)
+            keys.push_back(key_fn(obj(PyList_GET_ITEM(_p, i), true)));
+        if(PyList_GET_SIZE(_p) != n)
+            throw err("list modified during sort_by");
+
+        std::vector<obj> held; held.reserve(n);
+        for(Py_ssize_t i = 0; i < n; i++)
+            held.push_back(obj(PyList_GET_ITEM(_p, i), true));
+        std::vector<Py_ssize_t> perm(n);
+        for(Py_ssize_t i = 0; i < n; i++)
+            perm[i] = i;
+        const key_t* k = keys.data();
+        std::exception_ptr e;
+        Py_BEGIN_ALLOW_THREADS
+        try{
+            if(reverse)
+                details::parallel_stable_sort(perm.begin(), perm.end(),
+                    [k](Py_ssize_t a, Py_ssize_t b){ return k[b] < k[a]; });
+            else
+                details::parallel_stable_sort(perm.begin(), perm.end(),
+                    [k](Py_ssize_t a, Py_ssize_t b){ return k[a] < k[b]; });
+        }
+        catch(...){
+            e = std::current_exception();
+        }
+        Py_END_ALLOW_THREADS
+        if(e)
+            std::rethrow_exception(e);
+
+        PyObject** items = PySequence_Fast_ITEMS(_p);
+        if(PyList_GET_SIZE(_p) != n || !std::equal(held.begin(), held.end(), items,
+            [](const obj& a, PyObject* b){ return a.p() == b; }))
+            throw err("list modified during sort_by");
+        std::vector<PyObject*> sorted(n);
+        for(Py_ssize_t i = 0; i < n; i++)
+            sorted[i] = items[perm[i]];
+        std::copy(sorted.begin(), sorted.end(), items);
+    }
+
     /** reverse in place.
      */
     void reverse()
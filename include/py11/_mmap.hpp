@@ -0,0 +1,191 @@
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace py{
+
+namespace details{
+
+/** an mmap'ed region, as a python object exporting it through the buffer interface.
+ * Each buffer holds a reference, so the region is unmapped when the last
+ * of its memoryviews (slices included) and its mapped_file are gone.
+ */
+struct mapping{
+    PyObject_HEAD
+    char* data;
+    size_t size;
+    bool writable;
+
+    static void tp_dealloc(PyObject* self)
+    {
+        mapping* m = (mapping*)self;
+        if(m->data)
+            munmap(m->data, m->size);
+        Py_TYPE(self)->tp_free(self);
+    }
+
+    static int getbuffer(PyObject* self, Py_buffer* v, int flags)
+    {
+        mapping* m = (mapping*)self;
+        return PyBuffer_FillInfo(v, self, m->data, m->size, !m->writable, flags);
+    }
+
+    /** the python type, readied on first use.
+     * @throw val_err
+     */
+    static PyTypeObject* type()
+    {
+        static PyTypeObject t;
+        static PyBufferProcs b;
+        if(!t.tp_name){
+            b.bf_getbuffer = &getbuffer;
+            Py_REFCNT(&t) = 1;
+            Py_TYPE(&t) = &PyType_Type;
+            t.tp_name = "py11.mapping";
+            t.tp_basicsize = sizeof(mapping);
+            t.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER;
+            t.tp_as_buffer = &b;
+            t.tp_dealloc = &tp_dealloc;
+            t.tp_free = &PyObject_Del;
+            if(PyType_Ready(&t) == -1){
+                t.tp_name = NULL;
+                throw val_err("mapping type failed");
+            }
+        }
+        return &t;
+    }
+};
+
+}; // ns details
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+/** a file mapped in memory, shared by c++ and python without copying.
+ * The mapping belongs to a python object; memoryview() objects hold it too,
+ * so the pages stay mapped until the last of them and the mapped_file are gone.
+ * Create, copy and destroy it with the GIL held; data() needs no GIL.
+ */
+class mapped_file{
+private:
+    obj _map;
+    char* _data;
+    size_t _size;
+    bool _writable;
+
+public:
+    enum mode_t{ read_only, read_write };
+
+    mapped_file():_data(NULL), _size(0), _writable(false)
+    {}
+
+    /** map a whole file, shared with other mappings of it.
+     * @throw io_err
+     */
+    explicit mapped_file(const char* path, mode_t mode = read_only)
+        :_data(NULL), _size(0), _writable(mode == read_write)
+    {
+        int fd = open(path, _writable ? O_RDWR : O_RDONLY);
+        struct stat st;
+        if(fd == -1 || fstat(fd, &st) == -1){
+            PyErr_SetFromErrnoWithFilename(PyExc_IOError, (char*)path);
+            if(fd != -1)
+                close(fd);
+            throw io_err("mapped_file open failed");
+        }
+        _size = st.st_size;
+        if(_size){
+            void* p = mmap(NULL, _size, _writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+            if(p == MAP_FAILED){
+                PyErr_SetFromErrnoWithFilename(PyExc_IOError, (char*)path);
+                close(fd);
+                throw io_err("mapped_file mmap failed");
+            }
+            _data = (char*)p;
+        }
+        close(fd);
+
+        details::mapping* m = PyObject_New(details::mapping, details::mapping::type());
+        if(!m){
+            if(_data)
+                munmap(_data, _size);
+            throw val_err("mapped_file mapping failed");
+        }
+        m->data = _data;
+        m->size = _size;
+        m->writable = _writable;
+        _map = (PyObject*)m;
+    }
+
+    char* data()
+    {
+        return _data;
+    }
+
+    const char* data()const
+    {
+        return _data;
+    }
+
+    size_t size()const
+    {
+        return _size;
+    }
+
+    bool writable()const
+    {
+        return _writable;
+    }
+
+    const char* begin()const
+    {
+        return _data;
+    }
+
+    const char* end()const
+    {
+        return _data + _size;
+    }
+
+    str_view view()const
+    {
+        return str_view(_data ? _data : "", _size);
+    }
+
+    /** a python memoryview of the pages, writable for read_write maps.
+     * @throw val_err
+     */
+    obj memoryview()const
+    {
+        if(!_map)
+            throw val_err("mapped_file not open");
+        PyObject* r = PyMemoryView_FromObject(_map.p());
+        if(!r)
+            throw val_err("memoryview failed");
+        return r;
+    }
+
+    /** write changes back to the file.
+     * @throw io_err
+     */
+    void flush()
+    {
+        if(_data && _writable && msync(_data, _size, MS_SYNC) == -1){
+            PyErr_SetFromErrno(PyExc_IOError);
+            throw io_err("mapped_file flush failed");
+        }
+    }
+};
+
+/**
+ * @}
+ */
+
+}; // ns py
+
+#endif // _WIN32
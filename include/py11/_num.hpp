@@ -4,15 +4,15 @@ namespace py{
  */
 class num: public obj{
 protected:
-    void type_check(PyObject* p)noexcept(!PY11_ENFORCE)
+    void type_check(PyObject* p)noexcept(!PY11_ENFORCE_NUM)
     {
-        if(PY11_ENFORCE && p){
+        if(PY11_ENFORCE_NUM && p){
             if(!PyNumber_Check(p))
                 throw type_err("creating num failed");
         }
     }
     
-    void type_check(const obj& o)noexcept(!PY11_ENFORCE)
+    void type_check(const obj& o)noexcept(!PY11_ENFORCE_NUM)
     {
         type_check((PyObject*)o.p());
     }
@@ -21,6 +21,11 @@ public:
     /** ctor.
      */
     num()=default;
+
+    /** take a new reference known to be a num, without checking.
+     */
+    num(PyObject* p, unchecked_t)noexcept:obj(p)
+    {}
             
     num(const obj& o)
     {
@@ -38,13 +43,13 @@ public:
         return *this;
     }
 
-    num(obj&& o)noexcept(!PY11_ENFORCE)
+    num(obj&& o)noexcept(!PY11_ENFORCE_NUM)
     {
         type_check(o);
         _p = o.transfer();
     }
     
-    num& operator=(obj&& o)noexcept(!PY11_ENFORCE)
+    num& operator=(obj&& o)noexcept(!PY11_ENFORCE_NUM)
     {
         if(o.p()!=_p){
             type_check(o);
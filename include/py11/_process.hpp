@@ -0,0 +1,475 @@
+#ifndef _WIN32
+
+#include <marshal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+namespace py{
+
+namespace details{
+
+/** message between a process_pool and its workers.
+ * The payload is marshal data, in the worker's shared memory,
+ * or following the header on the socket if it doesn't fit.
+ */
+struct pool_msg{
+    enum kind_t{ call = 1, result, error, quit };
+    uint32_t kind;
+    uint32_t in_socket;
+    uint64_t len;
+};
+
+inline bool send_all(int fd, const void* p, size_t n)
+{
+    const char* s = (const char*)p;
+    while(n){
+        ssize_t r = ::send(fd, s, n, MSG_NOSIGNAL);
+        if(r <= 0){
+            if(r == -1 && errno == EINTR)
+                continue;
+            return false;
+        }
+        s += r;
+        n -= r;
+    }
+    return true;
+}
+
+inline bool recv_all(int fd, void* p, size_t n)
+{
+    char* s = (char*)p;
+    while(n){
+        ssize_t r = ::recv(fd, s, n, 0);
+        if(r <= 0){
+            if(r == -1 && errno == EINTR)
+                continue;
+            return false;
+        }
+        s += r;
+        n -= r;
+    }
+    return true;
+}
+
+/** send a payload through shm if it fits, otherwise through the socket.
+ */
+inline bool send_msg(int fd, char* shm, size_t shm_size, uint32_t kind, const char* p, size_t n)
+{
+    pool_msg m;
+    m.kind = kind;
+    m.in_socket = n > shm_size;
+    m.len = n;
+    if(!m.in_socket)
+        memcpy(shm, p, n);
+    return send_all(fd, &m, sizeof(m)) && (!m.in_socket || send_all(fd, p, n));
+}
+
+/** receive a message; the payload is in shm, or in buf if it came through the socket.
+ * @return pointer to the payload, NULL on failure
+ */
+inline const char* recv_msg(int fd, char* shm, pool_msg& m, std::vector<char>& buf)
+{
+    if(!recv_all(fd, &m, sizeof(m)))
+        return NULL;
+    if(!m.in_socket)
+        return shm;
+    buf.resize(m.len + 1);
+    if(!recv_all(fd, buf.data(), m.len))
+        return NULL;
+    return buf.data();
+}
+
+/** "Type: value" of the current python error, which is cleared.
+ */
+inline std::string fetch_err_text()
+{
+    PyObject *t, *v, *tb;
+    PyErr_Fetch(&t, &v, &tb);
+    PyErr_NormalizeException(&t, &v, &tb);
+    obj type(t), value(v), trace(tb);
+    std::string s = "unknown error";
+    if(!!type){
+        PyObject* name = PyObject_GetAttrString(t, "__name__");
+        s = name && PyString_Check(name) ? PyString_AS_STRING(name) : "error";
+        Py_XDECREF(name);
+    }
+    if(!!value){
+        PyObject* text = PyObject_Str(v);
+        if(text && PyString_Check(text)){
+            s += ": ";
+            s += PyString_AS_STRING(text);
+        }
+        Py_XDECREF(text);
+    }
+    PyErr_Clear();
+    return s;
+}
+
+/** worker process loop, never returns.
+ */
+inline void pool_worker(int fd, char* shm, size_t shm_size)
+{
+    PyOS_AfterFork();
+    std::vector<char> buf;
+    while(1){
+        pool_msg m;
+        const char* p = recv_msg(fd, shm, m, buf);
+        if(!p || m.kind != pool_msg::call){
+            fflush(NULL);
+            _exit(0);
+        }
+
+        uint32_t kind = pool_msg::result;
+        obj out;
+        obj req(PyMarshal_ReadObjectFromString((char*)p, m.len));
+        PyObject *mod, *name, *args;
+        if(!!req && PyArg_ParseTuple(req.p(), "SSO!", &mod, &name, &PyTuple_Type, &args)){
+            obj fn(PyImport_Import(mod));
+            if(!!fn)
+                fn = PyObject_GetAttr(fn.p(), name);
+            if(!!fn){
+                obj r(PyObject_CallObject(fn.p(), args));
+                if(!!r)
+                    out = PyMarshal_WriteObjectToString(r.p(), Py_MARSHAL_VERSION);
+            }
+        }
+        if(!out){
+            kind = pool_msg::error;
+            std::string e = fetch_err_text();
+            out = PyString_FromStringAndSize(e.data(), e.size());
+        }
+        if(!send_msg(fd, shm, shm_size, kind, PyString_AS_STRING(out.p()), PyString_GET_SIZE(out.p()))){
+            fflush(NULL);
+            _exit(1);
+        }
+    }
+}
+
+}; // ns details
+
+/**
+ * @addtogroup utils
+ * @{
+ */
+
+/** pool of forked python worker processes.
+ * Workers are forked from the current, initialized interpreter, so modules
+ * imported before are already loaded in them. A call sends the function's
+ * module and name, and the marshaled args, to a free worker; payloads go
+ * through a shared memory segment per worker, or the socket if they don't fit.
+ * Functions must be reachable as module.name, and args and results must be
+ * marshalable (None, bool, numbers, str, unicode, tuple, list, dict, set).
+ * Use it with the GIL held; it is released while waiting for workers.
+ * Create it before starting other threads: fork() copies only the calling
+ * thread, so a lock held elsewhere at that moment stays locked in the workers.
+ * For the same reason a lost worker is not forked again: it is dropped, and
+ * the pool goes on with the others.
+ */
+class process_pool{
+private:
+    struct worker{
+        pid_t pid;
+        int fd;
+        char* shm;
+    };
+
+    enum state_t{ idle, busy, dead };
+
+    size_t _shm_size;
+    std::vector<worker> _ws;
+    std::vector<state_t> _state;
+    size_t _live;
+    std::mutex _m;
+    std::condition_variable _cv;
+
+    /** take a free worker, waiting for one; without the GIL.
+     * @return its index, _ws.size() if no worker is left
+     */
+    size_t acquire()
+    {
+        std::vector<size_t> r = acquire_some(1);
+        return r.empty() ? _ws.size() : r[0];
+    }
+
+    /** take all free workers at once, up to max, waiting for at least one.
+     * Never holding some while waiting for more keeps concurrent calls from deadlocking.
+     * @return empty if no worker is left
+     */
+    std::vector<size_t> acquire_some(size_t max)
+    {
+        std::vector<size_t> r;
+        std::unique_lock<std::mutex> l(_m);
+        while(_live){
+            for(size_t i = 0; i < _ws.size() && r.size() < max; i++){
+                if(_state[i] == idle){
+                    _state[i] = busy;
+                    r.push_back(i);
+                }
+            }
+            if(!r.empty())
+                break;
+            _cv.wait(l);
+        }
+        return r;
+    }
+
+    void release(size_t i)
+    {
+        std::lock_guard<std::mutex> l(_m);
+        _state[i] = idle;
+        _cv.notify_all();
+    }
+
+    /** drop a worker whose socket failed: kill and reap it; without the GIL.
+     */
+    void lose(size_t i)
+    {
+        worker& w = _ws[i];
+        close(w.fd);
+        kill(w.pid, SIGKILL);
+        while(waitpid(w.pid, NULL, 0) == -1 && errno == EINTR)
+            ;
+        munmap(w.shm, _shm_size);
+        std::lock_guard<std::mutex> l(_m);
+        _state[i] = dead;
+        _live--;
+        _cv.notify_all();
+    }
+
+    static obj request(const obj& fn, const obj& args)
+    {
+        obj mod(PyObject_GetAttrString(fn.p(), "__module__"));
+        obj name(PyObject_GetAttrString(fn.p(), "__name__"));
+        if(!mod || !name || !PyString_Check(mod.p()) || !PyString_Check(name.p()))
+            throw type_err("process_pool: fn has no module or name");
+        obj t = {mod, name, args};
+        PyObject* r = PyMarshal_WriteObjectToString(t.p(), Py_MARSHAL_VERSION);
+        if(!r)
+            throw val_err("process_pool: args can't be marshaled");
+        return r;
+    }
+
+    /** decode a reply, with the GIL held.
+     * @throw type_err for an error raised by the worker
+     */
+    static obj reply(const details::pool_msg& m, const char* p)
+    {
+        if(m.kind == details::pool_msg::error){
+            std::string e(p, m.len);
+            PyErr_SetString(PyExc_RuntimeError, e.c_str());
+            throw type_err("remote call failed");
+        }
+        PyObject* r = PyMarshal_ReadObjectFromString((char*)p, m.len);
+        if(!r)
+            throw val_err("process_pool: bad reply");
+        return r;
+    }
+
+    bool send(size_t i, const obj& req)
+    {
+        worker& w = _ws[i];
+        return details::send_msg(w.fd, w.shm, _shm_size, details::pool_msg::call,
+            PyString_AS_STRING(req.p()), PyString_GET_SIZE(req.p()));
+    }
+
+public:
+    /** fork n workers.
+     * @param shm_size  size of the shared memory segment of each worker
+     * @throw io_err
+     */
+    explicit process_pool(size_t n = std::thread::hardware_concurrency(), size_t shm_size = 16 << 20)
+        :_shm_size(shm_size), _live(0)
+    {
+        if(n == 0)
+            n = 1;
+        fflush(NULL);
+        for(size_t i = 0; i < n; i++){
+            worker w;
+            int fds[2];
+            w.shm = (char*)mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if(w.shm == MAP_FAILED || socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1)
+                throw io_err("process_pool: no shm or socket");
+            w.pid = fork();
+            if(w.pid == 0){
+                close(fds[0]);
+                for(auto& x: _ws)
+                    close(x.fd);
+                details::pool_worker(fds[1], w.shm, shm_size);
+            }
+            close(fds[1]);
+            w.fd = fds[0];
+            if(w.pid == -1){
+                close(w.fd);
+                munmap(w.shm, shm_size);
+                throw io_err("process_pool: fork failed");
+            }
+            _ws.push_back(w);
+            _state.push_back(idle);
+            _live++;
+        }
+    }
+
+    process_pool(const process_pool&) = delete;
+    process_pool& operator=(const process_pool&) = delete;
+
+    /** stop and reap the workers.
+     */
+    ~process_pool()
+    {
+        for(size_t i = 0; i < _ws.size(); i++){
+            if(_state[i] == dead)
+                continue;
+            details::pool_msg m = {details::pool_msg::quit, 0, 0};
+            details::send_all(_ws[i].fd, &m, sizeof(m));
+            close(_ws[i].fd);
+        }
+        for(size_t i = 0; i < _ws.size(); i++){
+            if(_state[i] == dead)
+                continue;
+            waitpid(_ws[i].pid, NULL, 0);
+            munmap(_ws[i].shm, _shm_size);
+        }
+    }
+
+    /** number of workers left.
+     */
+    size_t size()
+    {
+        std::lock_guard<std::mutex> l(_m);
+        return _live;
+    }
+
+    /** call fn(*args) in a worker, as fn.call(args).
+     * @throw type_err if fn raised, with the worker's error set as RuntimeError
+     * @throw val_err if args or the result can't be marshaled
+     * @throw io_err if the worker is lost, or none is left
+     */
+    obj call(const obj& fn, const obj& args)
+    {
+        obj req = request(fn, args);
+        size_t i;
+        details::pool_msg m;
+        std::vector<char> buf;
+        const char* p = NULL;
+        {
+            gil_scoped_release nogil;
+            i = acquire();
+            if(i != _ws.size()){
+                if(send(i, req))
+                    p = details::recv_msg(_ws[i].fd, _ws[i].shm, m, buf);
+                if(!p)
+                    lose(i);
+            }
+        }
+        if(i == _ws.size())
+            throw io_err("process_pool: no worker left");
+        if(!p)
+            throw io_err("process_pool: worker lost");
+        try{
+            obj r = reply(m, p);
+            release(i);
+            return r;
+        }
+        catch(...){
+            release(i);
+            throw;
+        }
+    }
+
+    /** call fn(*args) for each args tuple of arg_list, spread over the free workers.
+     * @return list of results, in order
+     * @throw same as call()
+     */
+    list map(const obj& fn, const obj& arg_list)
+    {
+        list items(PySequence_List(arg_list.p()), unchecked);
+        if(!items)
+            throw type_err("process_pool: bad arg_list");
+        Py_ssize_t n = items.size();
+        list results(PyList_New(n), unchecked);
+        for(Py_ssize_t k = 0; k < n; k++){
+            Py_INCREF(Py_None);
+            PyList_SET_ITEM(results.p(), k, Py_None);
+        }
+
+        if(n == 0)
+            return results;
+        std::vector<size_t> ws;
+        {
+            gil_scoped_release nogil;
+            ws = acquire_some(n);
+        }
+        if(ws.empty())
+            throw io_err("process_pool: no worker left");
+        std::vector<Py_ssize_t> job(ws.size(), -1);
+        std::vector<char> lost(ws.size(), 0);
+        std::vector<pollfd> fds(ws.size());
+        std::vector<char> buf;
+        Py_ssize_t next = 0, done = 0;
+        try{
+            while(done < n){
+                for(size_t k = 0; k < ws.size() && next < n; k++){
+                    if(job[k] == -1){
+                        if(!send(ws[k], request(fn, items[next]))){
+                            lost[k] = 1;
+                            throw io_err("process_pool: worker lost");
+                        }
+                        job[k] = next++;
+                    }
+                }
+                for(size_t k = 0; k < ws.size(); k++){
+                    fds[k].fd = job[k] == -1 ? -1 : _ws[ws[k]].fd;
+                    fds[k].events = POLLIN;
+                    fds[k].revents = 0;
+                }
+                {
+                    gil_scoped_release nogil;
+                    while(poll(fds.data(), fds.size(), -1) == -1 && errno == EINTR)
+                        ;
+                }
+                for(size_t k = 0; k < ws.size(); k++){
+                    if(!fds[k].revents)
+                        continue;
+                    worker& w = _ws[ws[k]];
+                    details::pool_msg m;
+                    const char* p = details::recv_msg(w.fd, w.shm, m, buf);
+                    if(!p){
+                        lost[k] = 1;
+                        throw io_err("process_pool: worker lost");
+                    }
+                    Py_ssize_t j = job[k];
+                    job[k] = -1;
+                    PyList_SetItem(results.p(), j, reply(m, p).transfer());
+                    done++;
+                }
+            }
+        }
+        catch(...){
+            // wait for the replies in flight, so the workers can be reused
+            gil_scoped_release nogil;
+            for(size_t k = 0; k < ws.size(); k++){
+                details::pool_msg m;
+                if(lost[k] || (job[k] != -1 && !details::recv_msg(_ws[ws[k]].fd, _ws[ws[k]].shm, m, buf)))
+                    lose(ws[k]);
+                else
+                    release(ws[k]);
+            }
+            throw;
+        }
+        for(auto i: ws)
+            release(i);
+        return results;
+    }
+};
+
+/**
+ * @}
+ */
+
+}; // ns py
+
+#endif // _WIN32
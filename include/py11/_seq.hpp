@@ -7,15 +7,15 @@ class list;
  */
 class seq: public obj{
 protected:
-    void type_check(PyObject* p)noexcept(!PY11_ENFORCE)
+    void type_check(PyObject* p)noexcept(!PY11_ENFORCE_SEQ)
     {
-        if(PY11_ENFORCE && p){
+        if(PY11_ENFORCE_SEQ && p){
             if(!PySequence_Check(p))
                 throw type_err("creating seq failed");
         }
     }
     
-    void type_check(const obj& o)noexcept(!PY11_ENFORCE)
+    void type_check(const obj& o)noexcept(!PY11_ENFORCE_SEQ)
     {
         type_check((PyObject*)o.p());
     }
@@ -24,6 +24,11 @@ public:
     /** ctor.
      */
     seq()=default;
+
+    /** take a new reference known to be a seq, without checking.
+     */
+    seq(PyObject* p, unchecked_t)noexcept:obj(p)
+    {}
             
     seq(const obj& o)
     {
@@ -41,13 +46,13 @@ public:
         return *this;
     }
 
-    seq(obj&& o)noexcept(!PY11_ENFORCE)
+    seq(obj&& o)noexcept(!PY11_ENFORCE_SEQ)
     {
         type_check(o);
         _p = o.transfer();
     }
     
-    seq& operator=(obj&& o)noexcept(!PY11_ENFORCE)
+    seq& operator=(obj&& o)noexcept(!PY11_ENFORCE_SEQ)
     {
         if(o.p()!=_p){
             type_check(o);
@@ -175,6 +180,16 @@ public:
         return r;
     }
 
+    /** seq index, without throwing.
+     */
+    expected<long> try_index(const obj& o, err_policy policy = err_policy::clear)const
+    {
+        long r = PySequence_Index(_p, o.p());
+        if(r == -1)
+            return details::take_error(policy, "index failed", err_kind::val);
+        return r;
+    }
+
     /** get a list clone.
      * @throw type_err
      */    
@@ -187,46 +202,65 @@ public:
         
     /** get item.
      * Warning, a new obj will be got! not a reference to the original one!
-     * @throw index_err
+     * @throw the err throw_current() maps the raised exception to, index_err for an IndexError
      */
     const obj operator [](Py_ssize_t i)const
     {
         PyObject* p = PySequence_GetItem(_p, i);
         if(!p){
-            throw index_err("non-existing item");
+            throw_current("non-existing item");
         }
         return p;
     }
+
+    /** get item, without throwing.
+     */
+    expected<obj> try_get(Py_ssize_t i, err_policy policy = err_policy::clear)const
+    {
+        PyObject* p = PySequence_GetItem(_p, i);
+        if(!p)
+            return details::take_error(policy, "non-existing item");
+        return obj(p);
+    }
     
     /** set_item.
-     * @throw index_err
+     * @throw the err throw_current() maps the raised exception to
      */
     void set_item(Py_ssize_t i, const obj& value)const
     {
         int r = PySequence_SetItem(_p, i, value.p());
         if(r == -1)
-            throw index_err("set_item failed");
+            throw_current("set_item failed");
     }
     
     /** del_item.
-     * @throw index_err
+     * @throw the err throw_current() maps the raised exception to
      */
     void del_item(Py_ssize_t i)
     {
         int r = PySequence_DelItem(_p, i);
         if(r == -1)
-            throw index_err("del_item failed");
+            throw_current("del_item failed");
     }
     
     /** slice, [i:j].
      * @throw type_err
      */
-    obj sub(int i, int j = std::numeric_limits<int>::max())const
+    obj sub(Py_ssize_t i, Py_ssize_t j = PY_SSIZE_T_MAX)const
     {
         PyObject* p = PySequence_GetSlice(_p, i, j);
         if(!p)
             throw type_err("sub failed");
         return p;
+    }
+
+    /** extended slice, [i:j:step].
+     * @throw val_err if step is 0
+     * @throw type_err
+     */
+    obj sub(Py_ssize_t i, Py_ssize_t j, Py_ssize_t step)const
+    {
+        return details::get_slice(_p, i, j, step);
     }    
 };
 
@@ -4,15 +4,15 @@ namespace py{
  */
 class set: public num{
 protected:
-    void type_check(PyObject* p)noexcept(!PY11_ENFORCE)
+    void type_check(PyObject* p)noexcept(!PY11_ENFORCE_SET)
     {
-        if(PY11_ENFORCE && p){
-            if(!PyAnySet_Check(p))
+        if(PY11_ENFORCE_SET && p && !PyAnySet_CheckExact(p)){
+            if(PY11_ENFORCE_SET >= 2 || !PyAnySet_Check(p))
                 throw type_err("creating set failed");
         }
     }
     
-    void type_check(const obj& o)noexcept(!PY11_ENFORCE)
+    void type_check(const obj& o)noexcept(!PY11_ENFORCE_SET)
     {
         type_check((PyObject*)o.p());
     }
@@ -21,6 +21,11 @@ public:
     /** ctor.
      */
     set()=default;
+
+    /** take a new reference known to be a set, without checking.
+     */
+    set(PyObject* p, unchecked_t)noexcept:num(p, unchecked)
+    {}
             
     set(const obj& o)
     {
@@ -38,13 +43,13 @@ public:
         return *this;
     }
 
-    set(obj&& o)noexcept(!PY11_ENFORCE)
+    set(obj&& o)noexcept(!PY11_ENFORCE_SET)
     {
         type_check(o);
         _p = o.transfer();
     }
     
-    set& operator=(obj&& o)noexcept(!PY11_ENFORCE)
+    set& operator=(obj&& o)noexcept(!PY11_ENFORCE_SET)
     {
         if(o.p()!=_p){
             type_check(o);
@@ -212,15 +217,102 @@ public:
         throw index_err("set pop failed");
     }
     
+    /** create a set from a c++ range.
+     * each element is converted to obj.
+     * @throw val_err
+     */
+    template<typename It> static set from_range(It first, It last)
+    {
+        set r(PySet_New(NULL), unchecked);
+        if(!r)
+            throw val_err("set from_range failed");
+        r.extend(first, last);
+        return r;
+    }
+
     /** add elements from an iterable object.
+     * set, frozenset and dict sources are merged in one pass,
+     * reusing their stored hashes.
+     * @throw val_err
      */
     void extend(const obj& o)
     {
+        PyObject* p = o.p();
+        if(_p && p && (PyAnySet_Check(p) || PyDict_CheckExact(p))){
+            if(_PySet_Update(_p, p) == -1)
+                throw val_err("set extend failed");
+            return;
+        }
         for(auto &x: o){
             add(x);
         }
     }
 
+    /** add elements from a c++ range.
+     * each element is converted to obj.
+     * @throw val_err
+     */
+    template<typename It> void extend(It first, It last)
+    {
+        if(!_p)
+            throw val_err("set extend failed");
+        for(; first != last; ++first){
+            obj x(*first);
+            if(!x || PySet_Add(_p, x.p()) == -1)
+                throw val_err("set extend failed");
+        }
+    }
+
+    /** test many elements at once.
+     * bit i of bitmap (LSB first, (n+7)/8 bytes) is set if keys[i] is in the set.
+     * @return number of keys found
+     * @throw type_err for a null or unhashable key
+     */
+    size_t contains_many(const obj* keys, size_t n, unsigned char* bitmap)const
+    {
+        if(!_p)
+            throw type_err("contains_many failed");
+        size_t found = 0;
+        for(size_t i = 0; i < n; i += 8){
+            unsigned char bits = 0;
+            size_t m = n - i < 8 ? n - i : 8;
+            for(size_t j = 0; j < m; j++){
+                if(!keys[i + j])
+                    throw type_err("contains_many null key");
+                int r = PySet_Contains(_p, keys[i + j].p());
+                if(r == -1)
+                    throw type_err("contains_many failed");
+                bits |= (unsigned char)(r << j);
+                found += r;
+            }
+            bitmap[i / 8] = bits;
+        }
+        return found;
+    }
+
+    /** test many elements at once.
+     * @param out  resized to keys.size(), out[i] is true if keys[i] is in the set
+     * @return number of keys found
+     * @throw type_err for a null or unhashable key
+     */
+    size_t contains_many(const std::vector<obj>& keys, std::vector<bool>& out)const
+    {
+        if(!_p)
+            throw type_err("contains_many failed");
+        size_t found = 0;
+        out.resize(keys.size());
+        for(size_t i = 0; i < keys.size(); i++){
+            if(!keys[i])
+                throw type_err("contains_many null key");
+            int r = PySet_Contains(_p, keys[i].p());
+            if(r == -1)
+                throw type_err("contains_many failed");
+            out[i] = r;
+            found += r;
+        }
+        return found;
+    }
+
     /** clear.
      */
     void clear()
@@ -0,0 +1,232 @@
+namespace py{
+
+namespace details{
+
+/** clip [start:stop:step] against a sequence of length len, as python does.
+ * @return the slice length
+ * @throw val_err if step is 0
+ */
+inline Py_ssize_t slice_adjust(Py_ssize_t len, Py_ssize_t& start, Py_ssize_t& stop, Py_ssize_t step)
+{
+    if(step == 0)
+        throw val_err("slice step is zero");
+    if(start < 0){
+        start += len;
+        if(start < 0)
+            start = step < 0 ? -1 : 0;
+    }
+    else if(start >= len)
+        start = step < 0 ? len - 1 : len;
+    if(stop < 0){
+        stop += len;
+        if(stop < 0)
+            stop = step < 0 ? -1 : 0;
+    }
+    else if(stop >= len)
+        stop = step < 0 ? len - 1 : len;
+
+    if(step < 0)
+        return stop < start ? (start - stop - 1) / (-step) + 1 : 0;
+    return start < stop ? (stop - start - 1) / step + 1 : 0;
+}
+
+/** get [i:j:step] of a sequence through a slice object.
+ * @throw type_err
+ */
+inline PyObject* get_slice(PyObject* p, Py_ssize_t i, Py_ssize_t j, Py_ssize_t step)
+{
+    if(step == 0)
+        throw val_err("slice step is zero");
+    obj s(PySlice_New(obj(PyInt_FromSsize_t(i)).p(), obj(PyInt_FromSsize_t(j)).p(),
+        obj(PyInt_FromSsize_t(step)).p()));
+    if(!s)
+        throw type_err("sub failed");
+    PyObject* r = PyObject_GetItem(p, s.p());
+    if(!r)
+        throw type_err("sub failed");
+    return r;
+}
+
+}; // ns details
+
+/** non-owning view of [i:j:step] of a list, tuple or str.
+ * Elements are read in place, no new sequence is created.
+ * For list and tuple, elements are borrowed PyObject*; for str, chars.
+ * The view keeps the sequence alive, but is invalidated if a list is resized.
+ */
+template<typename T> class slice_view{
+private:
+    obj _o;
+    const T* _base;
+    Py_ssize_t _start;
+    Py_ssize_t _len;
+    Py_ssize_t _step;
+
+public:
+    /** random access iterator over the view.
+     */
+    class const_iterator{
+    private:
+        const T* _base;
+        Py_ssize_t _i;
+        Py_ssize_t _step;
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef Py_ssize_t difference_type;
+        typedef const T* pointer;
+        typedef const T& reference;
+
+        const_iterator():_base(NULL), _i(0), _step(1)
+        {}
+
+        const_iterator(const T* base, Py_ssize_t i, Py_ssize_t step):_base(base), _i(i), _step(step)
+        {}
+
+        const T& operator*()const
+        {
+            return _base[_i];
+        }
+
+        const T& operator[](Py_ssize_t k)const
+        {
+            return _base[_i + k * _step];
+        }
+
+        const_iterator& operator++()
+        {
+            _i += _step;
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator r = *this;
+            _i += _step;
+            return r;
+        }
+
+        const_iterator& operator--()
+        {
+            _i -= _step;
+            return *this;
+        }
+
+        const_iterator operator--(int)
+        {
+            const_iterator r = *this;
+            _i -= _step;
+            return r;
+        }
+
+        const_iterator& operator+=(Py_ssize_t k)
+        {
+            _i += k * _step;
+            return *this;
+        }
+
+        const_iterator& operator-=(Py_ssize_t k)
+        {
+            _i -= k * _step;
+            return *this;
+        }
+
+        const_iterator operator+(Py_ssize_t k)const
+        {
+            return const_iterator(_base, _i + k * _step, _step);
+        }
+
+        friend const_iterator operator+(Py_ssize_t k, const const_iterator& it)
+        {
+            return it + k;
+        }
+
+        const_iterator operator-(Py_ssize_t k)const
+        {
+            return const_iterator(_base, _i - k * _step, _step);
+        }
+
+        Py_ssize_t operator-(const const_iterator& o)const
+        {
+            return (_i - o._i) / _step;
+        }
+
+        bool operator==(const const_iterator& o)const
+        {
+            return _i == o._i;
+        }
+
+        bool operator!=(const const_iterator& o)const
+        {
+            return _i != o._i;
+        }
+
+        bool operator<(const const_iterator& o)const
+        {
+            return *this - o < 0;
+        }
+
+        bool operator>(const const_iterator& o)const
+        {
+            return *this - o > 0;
+        }
+
+        bool operator<=(const const_iterator& o)const
+        {
+            return *this - o <= 0;
+        }
+
+        bool operator>=(const const_iterator& o)const
+        {
+            return *this - o >= 0;
+        }
+    };
+
+    typedef const_iterator iterator;
+
+    slice_view():_base(NULL), _start(0), _len(0), _step(1)
+    {}
+
+    /** view [i:j:step] of the len items at base, owned by o.
+     * @throw val_err if step is 0
+     */
+    slice_view(const obj& o, const T* base, Py_ssize_t len,
+        Py_ssize_t i, Py_ssize_t j, Py_ssize_t step):_o(o), _base(base), _start(i), _step(step)
+    {
+        _len = details::slice_adjust(len, _start, j, step);
+    }
+
+    Py_ssize_t size()const
+    {
+        return _len;
+    }
+
+    bool empty()const
+    {
+        return _len == 0;
+    }
+
+    Py_ssize_t step()const
+    {
+        return _step;
+    }
+
+    /** the k-th element of the view, unchecked.
+     */
+    const T& operator[](Py_ssize_t k)const
+    {
+        return _base[_start + k * _step];
+    }
+
+    const_iterator begin()const
+    {
+        return const_iterator(_base, _start, _step);
+    }
+
+    const_iterator end()const
+    {
+        return const_iterator(_base, _start + _len * _step, _step);
+    }
+};
+
+}; // ns py
@@ -1,18 +1,20 @@
 namespace py{
 
+class str_view;
+
 /** py str.
  */
 class str: public seq{
 protected:
-    void type_check(PyObject* p)noexcept(!PY11_ENFORCE)
+    void type_check(PyObject* p)noexcept(!PY11_ENFORCE_STR)
     {
-        if(PY11_ENFORCE && p){
-            if(!PyString_Check(p))
+        if(PY11_ENFORCE_STR && p && !PyString_CheckExact(p)){
+            if(PY11_ENFORCE_STR >= 2 || !PyString_Check(p))
                 throw type_err("creating str failed");
         }
     }
     
-    void type_check(const obj& o)noexcept(!PY11_ENFORCE)
+    void type_check(const obj& o)noexcept(!PY11_ENFORCE_STR)
     {
         type_check((PyObject*)o.p());
     }
@@ -21,14 +23,19 @@ public:
     /** ctor.
      */
     str()=default;
+
+    /** take a new reference known to be a str, without checking.
+     */
+    str(PyObject* p, unchecked_t)noexcept:seq(p, unchecked)
+    {}
     
-    str(const obj& o)noexcept(!PY11_ENFORCE)
+    str(const obj& o)noexcept(!PY11_ENFORCE_STR)
     {
         type_check(o);
         enter(o.p());
     }
     
-    str& operator=(const obj& o)noexcept(!PY11_ENFORCE)
+    str& operator=(const obj& o)noexcept(!PY11_ENFORCE_STR)
     {
         if(o.p()!=_p){
             type_check(o);
@@ -38,13 +45,13 @@ public:
         return *this;
     }
 
-    str(obj&& o)noexcept(!PY11_ENFORCE)
+    str(obj&& o)noexcept(!PY11_ENFORCE_STR)
     {
         type_check(o);
         _p = o.transfer();
     }
     
-    str& operator=(obj&& o)noexcept(!PY11_ENFORCE)
+    str& operator=(obj&& o)noexcept(!PY11_ENFORCE_STR)
     {
         if(o.p()!=_p){
             type_check(o);
@@ -145,6 +152,10 @@ public:
         return p;
     }
 
+    /** view of the inner buffer, valid while the python string is alive, see str_view.
+     */
+    inline str_view as_view()const;
+
     /** get item.
      * Warning, a new obj will be got! not a reference to the original one!
      * @throw index_err
@@ -161,13 +172,32 @@ public:
     /** slice, [i:j].
      * @throw type_err
      */
-    str sub(int i, int j = std::numeric_limits<int>::max())const
+    str sub(Py_ssize_t i, Py_ssize_t j = PY_SSIZE_T_MAX)const
     {
         PyObject* p = PySequence_GetSlice(_p, i, j);
         if(!p)
             throw type_err("sub failed");
         return p;
     }
+
+    /** extended slice, [i:j:step].
+     * @throw val_err if step is 0
+     * @throw type_err
+     */
+    str sub(Py_ssize_t i, Py_ssize_t j, Py_ssize_t step)const
+    {
+        return details::get_slice(_p, i, j, step);
+    }
+
+    /** view of [i:j:step] without copying, yielding chars.
+     * @throw val_err if step is 0, or for a null str
+     */
+    slice_view<char> view(Py_ssize_t i = 0, Py_ssize_t j = PY_SSIZE_T_MAX, Py_ssize_t step = 1)const
+    {
+        if(!_p)
+            throw val_err("view of a null str");
+        return slice_view<char>(*this, PyString_AS_STRING(_p), PyString_GET_SIZE(_p), i, j, step);
+    }
     
     /** op +.
      * @throw type_err
@@ -215,4 +245,124 @@ public:
     }
 };
 
+/** non-owning view of chars, such as the buffer of a py::str.
+ * Compared by bytes, so it can be used as a native sort or hash key.
+ * It holds no reference: the chars must outlive it. A view from
+ * str::as_view() is valid while the python string object is alive, not just
+ * the py::str it came from; e.g. sort_by keys of list items stay valid
+ * because the list holds the items. Use to_string() or to_str() to keep a copy.
+ */
+class str_view{
+private:
+    const char* _s;
+    size_t _n;
+public:
+    str_view():_s(""), _n(0)
+    {}
+
+    str_view(const char* s, size_t n):_s(s), _n(n)
+    {}
+
+    str_view(const char* s):_s(s), _n(strlen(s))
+    {}
+
+    const char* data()const
+    {
+        return _s;
+    }
+
+    size_t size()const
+    {
+        return _n;
+    }
+
+    bool empty()const
+    {
+        return _n == 0;
+    }
+
+    char operator [](size_t i)const
+    {
+        return _s[i];
+    }
+
+    const char* begin()const
+    {
+        return _s;
+    }
+
+    const char* end()const
+    {
+        return _s + _n;
+    }
+
+    /** compare by bytes, as strcmp.
+     */
+    int compare(const str_view& o)const
+    {
+        int r = memcmp(_s, o._s, _n < o._n ? _n : o._n);
+        if(r)
+            return r;
+        return _n < o._n ? -1 : (_n > o._n ? 1 : 0);
+    }
+
+    bool operator ==(const str_view& o)const
+    {
+        return _n == o._n && memcmp(_s, o._s, _n) == 0;
+    }
+
+    bool operator !=(const str_view& o)const
+    {
+        return !(*this == o);
+    }
+
+    bool operator <(const str_view& o)const
+    {
+        return compare(o) < 0;
+    }
+
+    bool operator <=(const str_view& o)const
+    {
+        return compare(o) <= 0;
+    }
+
+    bool operator >(const str_view& o)const
+    {
+        return compare(o) > 0;
+    }
+
+    bool operator >=(const str_view& o)const
+    {
+        return compare(o) >= 0;
+    }
+
+    /** copy to a std::string.
+     */
+    std::string to_string()const
+    {
+        return std::string(_s, _n);
+    }
+
+    /** copy to a new py str.
+     * @throw val_err
+     */
+    str to_str()const
+    {
+        return str(_s, (Py_ssize_t)_n);
+    }
+};
+
+inline str_view str::as_view()const
+{
+    return str_view(PyString_AS_STRING(_p), PyString_GET_SIZE(_p));
+}
+
+/** ostream output
+ */
+inline std::ostream& operator <<(std::ostream& s, const str_view& v)
+{
+    s.write(v.data(), v.size());
+    return s;
+}
+
 }; // ns py
@@ -9,12 +9,112 @@ namespace py{
  * @{
  */
 
+namespace details{
+
+/** run by interpreter before finalizing python, to drop cached objs.
+ */
+inline std::vector<void(*)()>& fini_hooks()
+{
+    static std::vector<void(*)()> h;
+    return h;
+}
+
+};
+
+/** interpreter start-up options.
+ */
+struct init_options{
+    /** don't import site, as python -S.
+     */
+    bool no_site;
+
+    /** ignore PYTHON* environment variables, as python -E.
+     */
+    bool ignore_environment;
+
+    /** optimize level, as python -O or -OO.
+     */
+    int optimize;
+
+    /** install python's signal handlers.
+     */
+    bool install_signals;
+
+    /** program name, must stay valid while the interpreter is alive.
+     */
+    char* program_name;
+
+    /** sys.argv, not set if argv is NULL.
+     */
+    int argc;
+    char** argv;
+
+    /** prepend the script's directory to sys.path when setting sys.argv.
+     */
+    bool update_path;
+
+    /** enable threads, so other threads can take the GIL.
+     * The creating thread still holds the GIL after start-up;
+     * release it with gil_scoped_release to let other threads run.
+     */
+    bool init_threads;
+
+    init_options():no_site(false), ignore_environment(false), optimize(0),
+        install_signals(true), program_name(NULL), argc(0), argv(NULL), update_path(true),
+        init_threads(false)
+    {}
+};
+
+/** the python interpreter.
+ * Create one before using any obj, and keep it alive until all objs are released.
+ * If python is already initialized, e.g. inside an extension module,
+ * it is neither initialized again nor finalized.
+ */
+class interpreter{
+private:
+    bool _owner;
+
+public:
+    interpreter(const init_options& o = init_options()):_owner(!Py_IsInitialized())
+    {
+        if(_owner){
+            Py_NoSiteFlag = o.no_site;
+            Py_IgnoreEnvironmentFlag = o.ignore_environment;
+            Py_OptimizeFlag = o.optimize;
+            if(o.program_name)
+                Py_SetProgramName(o.program_name);
+            Py_InitializeEx(o.install_signals);
+        }
+        if(o.init_threads)
+            PyEval_InitThreads();
+        if(o.argv)
+            PySys_SetArgvEx(o.argc, o.argv, o.update_path);
+    }
+
+    interpreter(const interpreter&) = delete;
+    interpreter& operator=(const interpreter&) = delete;
+
+    ~interpreter()
+    {
+        if(_owner){
+            for(auto f: details::fini_hooks())
+                f();
+            Py_Finalize();
+        }
+    }
+
+    /** whether this object initialized python, and will finalize it.
+     */
+    bool owner()const
+    {
+        return _owner;
+    }
+};
+
 /** pass the args to set the correct sys.path in python
  */
 inline void set_arg(int argc, char *argv[])
 {
-	static details::py_initer_wrap __init;
-
 	PySys_SetArgv(argc, argv);
 }
 
@@ -27,17 +127,199 @@ inline void print_err(int set_sys_last_vars=1)
 		PyErr_PrintEx(set_sys_last_vars);
 }
 
+namespace details{
+
+struct cstr_hash{
+    size_t operator()(const char* s)const
+    {
+        size_t h = 14695981039346656037ULL;
+        for(; *s; s++)
+            h = (h ^ (unsigned char)*s) * 1099511628211ULL;
+        return h;
+    }
+};
+
+struct cstr_eq{
+    bool operator()(const char* a, const char* b)const
+    {
+        return strcmp(a, b) == 0;
+    }
+};
+
+/** imported modules by name, used with the GIL held.
+ */
+class import_cache{
+private:
+    std::list<std::string> _names;
+    std::unordered_map<const char*, obj, cstr_hash, cstr_eq> _m;
+    unsigned _gen;
+
+public:
+    import_cache():_gen(0)
+    {}
+
+    static import_cache& instance()
+    {
+        static import_cache* c = NULL;
+        if(!c){
+            c = new import_cache();
+            fini_hooks().push_back([]{ instance().clear(); });
+        }
+        return *c;
+    }
+
+    /** @return borrowed module, or NULL
+     */
+    PyObject* find(const char* name)const
+    {
+        auto i = _m.find(name);
+        return i == _m.end() ? NULL : i->second.p();
+    }
+
+    void add(const char* name, const obj& m)
+    {
+        _names.push_back(name);
+        _m[_names.back().c_str()] = m;
+    }
+
+    void clear()
+    {
+        _m.clear();
+        _names.clear();
+        _gen++;
+    }
+
+    /** changed by each clear().
+     */
+    unsigned generation()const
+    {
+        return _gen;
+    }
+};
+
+};
+
 /** py import.
+ * Modules are cached by name after the first import, so later calls
+ * skip the import machinery; see clear_import_cache().
  * @throw val_err
  */
 inline obj import(const char* module_name)
 {
-	static details::py_initer_wrap __init;
-
+    details::import_cache& c = details::import_cache::instance();
+    PyObject* m = c.find(module_name);
+    if(m)
+        return obj(m, true);
     PyObject* p = PyImport_ImportModule(module_name);
     if(p == NULL)
         throw val_err("py import () failed");
-    return p;
+    obj r(p);
+    c.add(module_name, r);
+    return r;
+}
+
+/** forget cached modules, e.g. after replacing entries of sys.modules.
+ */
+inline void clear_import_cache()
+{
+    details::import_cache::instance().clear();
+}
+
+/** module imported on first use.
+ * It keeps no reference itself, so it can be a static or global object.
+ */
+class module_ref{
+private:
+    const char* _name;
+    mutable PyObject* _m;
+    mutable unsigned _gen;
+
+public:
+    /** @param name  must stay valid, e.g. a string literal
+     */
+    explicit module_ref(const char* name):_name(name), _m(NULL), _gen(0)
+    {}
+
+    /** the module.
+     * @throw val_err
+     */
+    obj get()const
+    {
+        details::import_cache& c = details::import_cache::instance();
+        if(!_m || _gen != c.generation()){
+            _m = import(_name).p();
+            _gen = c.generation();
+        }
+        return obj(_m, true);
+    }
+
+    operator obj()const
+    {
+        return get();
+    }
+
+    /** get attr of the module.
+     * @throw val_err
+     * @throw attr_err
+     */
+    obj attr(const char* s)const
+    {
+        return get().attr(s);
+    }
+
+    /** get attr, short form.
+     * @throw val_err
+     * @throw attr_err
+     */
+    obj a(const char* s)const
+    {
+        return get().attr(s);
+    }
+
+    const char* name()const
+    {
+        return _name;
+    }
+};
+
+/** import time of a module, see preload().
+ */
+struct import_timing{
+    std::string name;
+    double seconds;
+};
+
+/** import modules at start-up.
+ * @param dependency_order  import the parent packages of a dotted name first,
+ * so that each reported time excludes its parents
+ * @return import time of each module, in import order
+ * @throw val_err
+ */
+inline std::vector<import_timing> preload(const std::vector<std::string>& names, bool dependency_order = false)
+{
+    std::vector<std::string> order;
+    for(auto& n: names){
+        if(dependency_order){
+            for(size_t i = n.find('.'); i != std::string::npos; i = n.find('.', i + 1)){
+                std::string parent = n.substr(0, i);
+                if(std::find(order.begin(), order.end(), parent) == order.end())
+                    order.push_back(parent);
+            }
+        }
+        if(std::find(order.begin(), order.end(), n) == order.end())
+            order.push_back(n);
+    }
+
+    std::vector<import_timing> r;
+    for(auto& n: order){
+        auto t0 = std::chrono::steady_clock::now();
+        import(n.c_str());
+        import_timing t;
+        t.name = n;
+        t.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        r.push_back(t);
+    }
+    return r;
 }
 
 /**
@@ -4,15 +4,15 @@ namespace py{
  */
 class tuple: public seq{
 protected:
-    void type_check(PyObject* p)noexcept(!PY11_ENFORCE)
+    void type_check(PyObject* p)noexcept(!PY11_ENFORCE_TUPLE)
     {
-        if(PY11_ENFORCE && p){
-            if(!PyTuple_Check(p))
+        if(PY11_ENFORCE_TUPLE && p && !PyTuple_CheckExact(p)){
+            if(PY11_ENFORCE_TUPLE >= 2 || !PyTuple_Check(p))
                 throw type_err("creating tuple failed");
         }
     }
     
-    void type_check(const obj& o)noexcept(!PY11_ENFORCE)
+    void type_check(const obj& o)noexcept(!PY11_ENFORCE_TUPLE)
     {
         type_check((PyObject*)o.p());
     }
@@ -21,14 +21,19 @@ public:
     /** ctor.
      */
     tuple()=default;
+
+    /** take a new reference known to be a tuple, without checking.
+     */
+    tuple(PyObject* p, unchecked_t)noexcept:seq(p, unchecked)
+    {}
     
-    tuple(const obj& o)noexcept(!PY11_ENFORCE)
+    tuple(const obj& o)noexcept(!PY11_ENFORCE_TUPLE)
     {
         type_check(o);
         enter(o.p());
     }
     
-    tuple& operator=(const obj& o)noexcept(!PY11_ENFORCE)
+    tuple& operator=(const obj& o)noexcept(!PY11_ENFORCE_TUPLE)
     {
         if(o.p()!=_p){
             type_check(o);
@@ -38,13 +43,13 @@ public:
         return *this;
     }
 
-    tuple(obj&& o)noexcept(!PY11_ENFORCE)
+    tuple(obj&& o)noexcept(!PY11_ENFORCE_TUPLE)
     {
         type_check(o);
         _p = o.transfer();
     }
     
-    tuple& operator=(obj&& o)noexcept(!PY11_ENFORCE)
+    tuple& operator=(obj&& o)noexcept(!PY11_ENFORCE_TUPLE)
     {
         if(o.p()!=_p){
             type_check(o);
@@ -151,13 +156,13 @@ public:
 
     /** get item.
      * Warning, a new obj will be got! not a reference to the original one!
-     * @throw index_err
+     * @throw the err throw_current() maps the raised exception to, index_err for an IndexError
      */
     const obj operator [](Py_ssize_t i)const
     {
         PyObject* p = PyTuple_GetItem(_p, i);
         if(!p){
-            throw index_err("non-existing item");
+            throw_current("non-existing item");
         }
         return obj(p, 1);
     }
@@ -165,13 +170,32 @@ public:
     /** slice, [i:j].
      * @throw type_err
      */
-    obj sub(int i, int j = std::numeric_limits<int>::max())const
+    obj sub(Py_ssize_t i, Py_ssize_t j = PY_SSIZE_T_MAX)const
     {
         PyObject* p = PyTuple_GetSlice(_p, i, j);
         if(!p)
             throw type_err("sub failed");
         return p;
     }
+
+    /** extended slice, [i:j:step].
+     * @throw val_err if step is 0
+     * @throw type_err
+     */
+    obj sub(Py_ssize_t i, Py_ssize_t j, Py_ssize_t step)const
+    {
+        return details::get_slice(_p, i, j, step);
+    }
+
+    /** view of [i:j:step] without copying, yielding borrowed items.
+     * @throw val_err if step is 0, or for a null tuple
+     */
+    slice_view<PyObject*> view(Py_ssize_t i = 0, Py_ssize_t j = PY_SSIZE_T_MAX, Py_ssize_t step = 1)const
+    {
+        if(!_p)
+            throw val_err("view of a null tuple");
+        return slice_view<PyObject*>(*this, PySequence_Fast_ITEMS(_p), PyTuple_GET_SIZE(_p), i, j, step);
+    }
 };
 
 }; // ns py
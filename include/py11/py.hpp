@@ -2,16 +2,97 @@
 #define PY11_PY_HPP
 
 #include <Python.h>
+#include <pythread.h>
+#include <frameobject.h>
 #include <iostream>
 #include <exception>
 #include <stdexcept>
 #include <initializer_list>
 #include <limits>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <type_traits>
+#include <functional>
+#include <memory>
+#include <new>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <list>
+#include <unordered_map>
+#include <chrono>
+
+#include <cassert>
 
 #ifndef PY11_ENFORCE
 #define PY11_ENFORCE 1
 #endif
 
+/** type checks of each wrapper: 0 none, 1 the type or a subclass, 2 the exact type.
+ * They default to PY11_ENFORCE.
+ */
+#ifndef PY11_ENFORCE_SEQ
+#define PY11_ENFORCE_SEQ PY11_ENFORCE
+#endif
+#ifndef PY11_ENFORCE_LIST
+#define PY11_ENFORCE_LIST PY11_ENFORCE
+#endif
+#ifndef PY11_ENFORCE_TUPLE
+#define PY11_ENFORCE_TUPLE PY11_ENFORCE
+#endif
+#ifndef PY11_ENFORCE_STR
+#define PY11_ENFORCE_STR PY11_ENFORCE
+#endif
+#ifndef PY11_ENFORCE_DICT
+#define PY11_ENFORCE_DICT PY11_ENFORCE
+#endif
+#ifndef PY11_ENFORCE_SET
+#define PY11_ENFORCE_SET PY11_ENFORCE
+#endif
+#ifndef PY11_ENFORCE_NUM
+#define PY11_ENFORCE_NUM PY11_ENFORCE
+#endif
+#ifndef PY11_ENFORCE_FILE
+#define PY11_ENFORCE_FILE PY11_ENFORCE
+#endif
+
+/** assert that obj operations run with the GIL held, for debugging.
+ */
+#ifndef PY11_CHECK_GIL
+#define PY11_CHECK_GIL 0
+#endif
+
+/** let obj be released on threads without the GIL.
+ * Such decrefs are queued and done in bulk by the next GIL holder.
+ */
+#ifndef PY11_DEFERRED_DECREF
+#define PY11_DEFERRED_DECREF 0
+#endif
+
+#if PY11_CHECK_GIL
+#define PY11_ASSERT_GIL() assert(py::gil_held())
+#else
+#define PY11_ASSERT_GIL()
+#endif
+
+namespace py {
+
+/** test whether the current thread holds the GIL.
+ */
+inline bool gil_held()
+{
+    PyThreadState* t = _PyThreadState_Current;
+    return t && t->thread_id == PyThread_get_thread_ident();
+}
+
+}; // ns py
+
 #include "_err.hpp"
 
 namespace py {
@@ -21,6 +102,16 @@ namespace py {
 
 class iter;
 
+namespace details{
+    inline void defer_decref(PyObject* p)noexcept;
+};
+
+/** constructor tag: the object is known to have the wrapper's type.
+ * The wrapper takes the new reference without a type check.
+ */
+struct unchecked_t{};
+constexpr unchecked_t unchecked = unchecked_t();
+
 class PPyObject {
 private:
     PyObject* _p;
@@ -39,34 +130,9 @@ public:
     }
 };
 
-namespace details{
-	class py_initer{
-	public:
-		py_initer()
-		{
-			//std::cout << ">>>>> init" << std::endl;
-			Py_Initialize();
-		}
-
-		~py_initer()
-		{
-			Py_Finalize();
-			//std::cout << ">>>>> fini" << std::endl;
-		}
-	};
-
-	class py_initer_wrap{
-	public:
-		py_initer_wrap()
-		{
-			static py_initer __init;
-		}
-	};
-};
-
 /** wrapper of PyObject.
  */
-class obj : private details::py_initer_wrap{
+class obj{
 friend class tuple;
 friend class list;
 friend class set;
@@ -89,6 +155,7 @@ protected:
     
     void __enter()noexcept
     {
+        PY11_ASSERT_GIL();
         if(_p)
             Py_INCREF(_p);
     }
@@ -131,6 +198,7 @@ public:
      */
     obj(PyObject* p, bool borrowed = false)noexcept:_p(p)
     {
+        PY11_ASSERT_GIL();
         if(borrowed)
             Py_XINCREF(_p);
     }
@@ -195,6 +263,14 @@ public:
     void release()noexcept
     {
         if(_p){
+#if PY11_DEFERRED_DECREF
+            if(!gil_held()){
+                details::defer_decref(_p);
+                _p = NULL;
+                return;
+            }
+#endif
+            PY11_ASSERT_GIL();
             Py_DECREF(_p);
             _p = NULL;
         }
@@ -336,6 +412,17 @@ public:
         return r;
     }
 
+    /** hash.
+     * @throw type_err if unhashable
+     */
+    long hash()const
+    {
+        long r = PyObject_Hash(_p);
+        if(r == -1)
+            throw type_err("hash failed");
+        return r;
+    }
+
     // attr
             
     /** has attr.
@@ -353,41 +440,61 @@ public:
     }
 
     /** get attr.
-     * @throw index_err
+     * @throw attr_err
      */
     obj attr(const obj& o)const
     {
         PyObject* p = PyObject_GetAttr(_p, o._p);
         if(!p){
-            throw index_err("non-existing attr");
+            throw attr_err("non-existing attr");
         }
         return p;
     }
 
     /** get attr.
-     * @throw index_err
+     * @throw attr_err
      */
     obj attr(const char* s)const
     {
         PyObject* p = PyObject_GetAttrString(_p, s);
         if(!p){
-            throw index_err("non-existing attr");
+            throw attr_err("non-existing attr");
         }
         return p;
     }
 
     /** get attr, short form.
-     * @throw index_err
+     * @throw attr_err
      */
     obj a(const char* s)const
     {
         PyObject* p = PyObject_GetAttrString(_p, s);
         if(!p){
-            throw index_err("non-existing attr");
+            throw attr_err("non-existing attr");
         }
         return p;
     }
 
+    /** get attr, without throwing.
+     */
+    expected<obj> try_attr(const obj& o, err_policy policy = err_policy::clear)const
+    {
+        PyObject* p = PyObject_GetAttr(_p, o._p);
+        if(!p)
+            return details::take_error(policy, "non-existing attr");
+        return obj(p);
+    }
+
+    /** get attr, without throwing.
+     */
+    expected<obj> try_attr(const char* s, err_policy policy = err_policy::clear)const
+    {
+        PyObject* p = PyObject_GetAttrString(_p, s);
+        if(!p)
+            return details::take_error(policy, "non-existing attr");
+        return obj(p);
+    }
+
     /** set attr.
      * @throw index_err
      */
@@ -586,37 +693,62 @@ public:
     }
     
     /** call using operator.
-     * @throw type_err
+     * @throw the err throw_current() maps the raised exception to, not always type_err
      */
     template<typename ...argT>obj operator ()(argT&& ...a)const
     {
+        PY11_ASSERT_GIL();
         PyObject* r = PyObject_CallFunctionObjArgs(_p, obj(a)._p..., NULL);
         if(r == NULL)
-            throw type_err("operator() failed");
+            throw_current("operator() failed");
         return r;
     }
 
     /** call with args.
-     * @throw type_err
+     * @throw the err throw_current() maps the raised exception to, not always type_err
      */
     obj call(const obj& args)const
     {
+        PY11_ASSERT_GIL();
         PyObject* r = PyObject_CallObject(_p, args._p);
         if(r == NULL)
-            throw type_err("call failed");
+            throw_current("call failed");
         return r;
     }
 
     /** call with args, and key/value pairs.
-     * @throw type_err
+     * @throw the err throw_current() maps the raised exception to, not always type_err
      */
     obj call(const obj& args, const obj& kw)const
     {
+        PY11_ASSERT_GIL();
         PyObject* r = PyObject_Call(_p, args._p, kw._p);
         if(r == NULL)
-            throw type_err("call failed");
+            throw_current("call failed");
         return r;
     }
+
+    /** call with args, without throwing.
+     */
+    expected<obj> try_call(const obj& args, err_policy policy = err_policy::clear)const
+    {
+        PY11_ASSERT_GIL();
+        PyObject* r = PyObject_CallObject(_p, args._p);
+        if(r == NULL)
+            return details::take_error(policy, "call failed");
+        return obj(r);
+    }
+
+    /** call with args, and key/value pairs, without throwing.
+     */
+    expected<obj> try_call(const obj& args, const obj& kw, err_policy policy = err_policy::clear)const
+    {
+        PY11_ASSERT_GIL();
+        PyObject* r = PyObject_Call(_p, args._p, kw._p);
+        if(r == NULL)
+            return details::take_error(policy, "call failed");
+        return obj(r);
+    }
         
     // container methods
     
@@ -672,35 +804,45 @@ public:
         
     /** get item.
      * Warning, a new obj will be got! not a reference to the original one!
-     * @throw index_err
+     * @throw the err throw_current() maps the raised exception to, key_err for a KeyError
      */
     const obj operator [](const obj& o)const
     {
         PyObject* p = PyObject_GetItem(_p, o._p);
         if(!p){
-            throw index_err("non-existing item");
+            throw_current("non-existing item");
         }
         return p;
     }
+
+    /** get item, without throwing.
+     */
+    expected<obj> try_get(const obj& o, err_policy policy = err_policy::clear)const
+    {
+        PyObject* p = PyObject_GetItem(_p, o._p);
+        if(!p)
+            return details::take_error(policy, "non-existing item");
+        return obj(p);
+    }
     
     /** set_item.
-     * @throw index_err
+     * @throw the err throw_current() maps the raised exception to
      */
     void set_item(const obj& key, const obj& value)
     {
         int r = PyObject_SetItem(_p, key._p, value._p);
         if(r == -1)
-            throw index_err("set_item failed");
+            throw_current("set_item failed");
     }
     
     /** del_item.
-     * @throw index_err
+     * @throw the err throw_current() maps the raised exception to, key_err for a KeyError
      */
     void del_item(const obj& key)
     {
         int r = PyObject_DelItem(_p, key._p);
         if(r == -1)
-            throw index_err("del_item failed");
+            throw_current("del_item failed");
     }
     
     /** get the begin iter.
@@ -760,6 +902,7 @@ inline std::ostream& operator <<(std::ostream& s, const obj& o)
 
 #include "_iter.hpp"
 
+#include "_slice.hpp"
 #include "_seq.hpp"
 #include "_tuple.hpp"
 #include "_list.hpp"
@@ -772,10 +915,24 @@ inline std::ostream& operator <<(std::ostream& s, const obj& o)
 
 #include "_dict.hpp"
 
+#include "_cmp.hpp"
+
 /* implementation
 ****************/
 
 #include "_sys.hpp"
+#include "_eval.hpp"
+#include "_frozen.hpp"
+#include "_decref.hpp"
+#include "_gil.hpp"
+#include "_executor.hpp"
+#include "_async.hpp"
+#include "_process.hpp"
+#include "_fork.hpp"
+#include "_deadline.hpp"
+#include "_mmap.hpp"
+#include "_def.hpp"
+#include "_class.hpp"
 
 namespace py {
 
@@ -793,7 +950,7 @@ inline list seq::to_list()const
 {
     PyObject* r = PySequence_List(_p);
     if(r)
-        return r;
+        return list(r, unchecked);
     throw type_err("to_list failed");
 }
 
@@ -801,7 +958,7 @@ inline tuple seq::to_tuple()const
 {
     PyObject* r = PySequence_Tuple(_p);
     if(r)
-        return r;
+        return tuple(r, unchecked);
     throw type_err("to_tuple failed");
 }
 
@@ -1 +1,7 @@
-g++-4.9 -O3 -g -o test test.cpp -I../include -I /usr/include/python2.7 -lpython2.7 -std=c++11
+g++-4.9 -O3 -g -o test test.cpp -I../include -I /usr/include/python2.7 -lpython2.7 -pthread -std=c++11
+
+# c++20 build, for the co_await support in _async.hpp
+g++ -O3 -g -o test20 test.cpp -I../include -I /usr/include/python2.7 -lpython2.7 -pthread -std=c++20
+
+# deferred decrefs and GIL checks
+g++ -O1 -g -o test_checked test.cpp -I../include -I /usr/include/python2.7 -lpython2.7 -pthread -std=c++11 -DPY11_DEFERRED_DECREF=1 -DPY11_CHECK_GIL=1 && ./test_checked
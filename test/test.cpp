@@ -1,12 +1,103 @@
 #include <py11/py.hpp>
 #include <iostream>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace std;
 
 //py::list a;
 
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+struct co_task {
+	struct promise_type {
+		co_task get_return_object() {
+			return {};
+		}
+		std::suspend_never initial_suspend() noexcept {
+			return {};
+		}
+		std::suspend_never final_suspend() noexcept {
+			return {};
+		}
+		void return_void() {
+		}
+		void unhandled_exception() {
+			std::terminate();
+		}
+	};
+};
+
+co_task co_sqrt(py::executor& ex, const py::obj& fn, std::promise<double>& out)
+{
+	out.set_value(co_await py::async_call<double>(ex, fn, 2.25));
+}
+
+co_task co_results(py::executor& ex, py::obj fn, std::promise<std::string>& out)
+{
+	// both results are used and dropped after resuming on the executor thread
+	std::string s = co_await py::async_call<std::string>(ex, fn, 0);
+	py::list l = co_await py::async_call<py::list>(ex, fn, 1);
+	out.set_value(s + " " + std::to_string(l.size()));
+}
+#endif
+
+static long ext_add(long a, long b)
+{
+	return a + b;
+}
+
+static std::string ext_greet(py::str_view who, int times)
+{
+	std::string r;
+	for (int i = 0; i < times; i++)
+		r += "hi " + who.to_string() + " ";
+	return r;
+}
+
+static py::list ext_pair(const py::obj& a, double b)
+{
+	return { a, b };
+}
+
+static void ext_fail(bool really)
+{
+	if (really)
+		throw std::runtime_error("c++ failure");
+}
+
+struct ext_point {
+	double x, y;
+	int tag;
+	std::string label;
+	py::obj extra;
+	const char* kind;
+
+	ext_point() :
+			x(0), y(0), tag(0), kind("point") {
+	}
+
+	ext_point(double x, double y) :
+			x(x), y(y), tag(0), kind("point") {
+	}
+
+	double norm2() const {
+		return x * x + y * y;
+	}
+
+	void scale(double k) {
+		x *= k;
+		y *= k;
+	}
+};
+
 int main(int argc, char** argv)
 {
+	py::init_options opt;
+	opt.init_threads = true;
+	py::interpreter interp(opt);
+
 	try {
 		//py::set_prog(argv[0]);
 
@@ -64,6 +155,22 @@ int main(int argc, char** argv)
 			}
 		}
 
+		{
+			cout << ">> unchecked" << endl;
+			py::list l(PyList_New(0), py::unchecked);
+			l.append(1);
+			py::dict g( { });
+			py::exec("class L(list): pass\nsub = L([1, 2])\n", g);
+			py::list sub = g["sub"];
+			cout << l << " " << sub.size() << " " << py::dict(g.copy()).size() << endl;
+			try {
+				py::tuple t = l;
+			}
+			catch (const py::type_err& e) {
+				cout << "caught: " << e.what() << endl;
+			}
+		}
+
 		{
 			cout << ">> set" << endl;
 			cout << "y: " << y << endl;
@@ -80,6 +187,24 @@ int main(int argc, char** argv)
 
 			s -= s1;
 			cout << "s -= s1 : " << s << endl;
+
+			long r[] = { 5, 6, 7, 5 };
+			py::set s2 = py::set::from_range(r, r + 4);
+			s2.extend(s1);
+			cout << "from_range + extend: " << s2 << endl;
+			std::vector<py::obj> keys = { 5, 9, 0, "abc" };
+			std::vector<bool> hit;
+			cout << "contains_many: " << s2.contains_many(keys, hit);
+			for (auto b : hit)
+				cout << " " << b;
+			cout << endl;
+			keys.push_back(py::obj());
+			try {
+				s2.contains_many(keys, hit);
+			}
+			catch (const py::type_err& e) {
+				cout << "caught: " << e.what() << endl;
+			}
 		}
 
 		{
@@ -97,7 +222,32 @@ int main(int argc, char** argv)
 			l.reverse();
 			cout << "reverse: " << l << endl;
 			cout << "[2:4]: " << l.sub(2, 4) << endl;
+			cout << "[::-2]: " << l.sub(-1, -5, -2) << endl;
+			cout << "view [1::2]:";
+			for (auto p : l.view(1, PY_SSIZE_T_MAX, 2)) {
+				cout << " " << py::obj(p, true);
+			}
+			cout << endl;
 			cout << "22 in l: " << l.has(22) << endl;
+
+			py::list w = { "pear", "fig", "apple" };
+			w.sort_by([](const py::obj& x) {return py::str(x).as_view();});
+			cout << "sort_by str: " << w << endl;
+			py::list big( { });
+			for (long i = 0; i < 200000; i++) {
+				big.append((i * 7919) % 200003);
+			}
+			big.sort_by([](const py::obj& x) {return x.as_long();}, true);
+			bool ok = true;
+			for (long i = 1; i < big.size(); i++) {
+				ok = ok && big[i - 1].as_long() >= big[i].as_long();
+			}
+			cout << "sort_by long, reverse: " << ok << endl;
+			try {
+				py::list().sort_by([](const py::obj& x) {return x.as_long();});
+			} catch (py::val_err& e) {
+				cout << "sort_by null: " << e.what() << endl;
+			}
 			cout << "l * 2: " << l * 2 << endl;
 			l *= 3;
 			cout << "l*=3: " << l << endl;
@@ -112,9 +262,450 @@ int main(int argc, char** argv)
 			}
 			cout << endl;
 			cout << a[1] << " " << a.sub(1, 4) << endl;
+			cout << a.sub(0, 5, 2) << " ";
+			for (auto c : a.view(-1, -6, -1)) {
+				cout << c;
+			}
+			cout << endl;
+			auto rv = a.view(-1, -6, -1);
+			auto rb = rv.begin(), re = rv.end();
+			cout << "view iter: " << (re - rb) << " " << *(re - 1) << " " << *(2 + rb)
+				<< " " << (rb < re) << (re > rb) << (rb <= rb) << (re >= rb) << " "
+				<< std::is_sorted(rv.begin(), rv.end(), std::greater<char>());
+			re -= 2;
+			re--;
+			cout << " " << *re << endl;
+			try {
+				py::list().view();
+			} catch (py::val_err& e) {
+				cout << "view null: " << e.what() << endl;
+			}
 			a = "%d";
 			cout << (a % py::obj( { 1 })) << endl;
 		}
+		{
+			cout << ">> expected" << endl;
+			py::dict d( { { "a", 1 } });
+			auto hit = d.try_get("a");
+			auto miss = d.try_get("b");
+			cout << hit.has_value() << *hit << " " << miss.has_value()
+					<< (miss.error().kind() == py::err_kind::key) << endl;
+			auto bad = d.try_get(py::list( { }), py::err_policy::keep);
+			cout << "unhashable: " << (bad.error().kind() == py::err_kind::type)
+					<< !!PyErr_Occurred() << endl;
+			PyErr_Clear();
+			py::list l = { 1, 2, 3 };
+			cout << l.try_index(2).value() << " " << l.try_index(9).value_or(-1) << " "
+					<< l.try_get(5).has_value() << " " << !PyErr_Occurred() << endl;
+			auto at = l.try_attr("nope", py::err_policy::keep);
+			cout << (at.error().kind() == py::err_kind::attr) << !!PyErr_Occurred() << endl;
+			PyErr_Clear();
+			auto r = py::obj(py::import("math").a("sqrt")).try_call(py::obj( { "x", 1 }));
+			cout << (r.error().kind() == py::err_kind::type) << endl;
+			try {
+				r.value();
+			}
+			catch (const py::type_err& e) {
+				cout << "caught: " << e.what() << endl;
+			}
+		}
+		{
+			cout << ">> err" << endl;
+			py::obj d = py::dict( { { "a", 1 } });
+			try {
+				d["b"];
+			}
+			catch (const py::key_err& e) {
+				cout << "key_err: " << e.what() << endl;
+			}
+			try {
+				d.attr("nope");
+			}
+			catch (const py::index_err& e) {
+				cout << "attr_err: " << (dynamic_cast<const py::attr_err*>(&e) != NULL)
+						<< (e.type() == PyExc_AttributeError) << endl;
+			}
+			PyErr_Clear();
+			py::dict g( { });
+			py::exec("class Custom(Exception): pass\n"
+					"def gen():\n"
+					"    yield 1\n"
+					"    raise Custom('bad')\n"
+					"def fail(kind):\n"
+					"    raise kind('from call')\n", g);
+			struct custom_err: py::err {
+				custom_err(const char* w) :
+						py::err(w) {
+				}
+			};
+			py::register_exception<custom_err>(g["Custom"].p());
+			try {
+				for (auto& x : py::obj(g["gen"]())) {
+					cout << x << " ";
+				}
+			}
+			catch (const custom_err& e) {
+				cout << "custom: " << e.what() << endl;
+				PyErr_Clear();
+				e.restore();
+				cout << "restored: " << !!PyErr_Occurred() << endl;
+			}
+			PyErr_Clear();
+			try {
+				g["fail"].call(PyTuple_Pack(1, g["Custom"].p()));
+			}
+			catch (const custom_err& e) {
+				cout << "custom from call: " << e.what() << endl;
+			}
+			try {
+				g["fail"](py::obj(PyExc_ValueError, true));
+			}
+			catch (const py::val_err& e) {
+				cout << "val_err from call: " << (e.type() == PyExc_ValueError) << endl;
+			}
+			try {
+				py::dict(g).del_item("missing");
+			}
+			catch (const py::key_err& e) {
+				cout << "key_err from del_item: " << (e.type() == PyExc_KeyError) << endl;
+				PyErr_Clear();
+			}
+			try {
+				py::eval("{}['x']");
+			}
+			catch (const py::key_err& e) {
+				cout << "key_err from eval: " << (e.type() == PyExc_KeyError) << endl;
+				PyErr_Clear();
+			}
+			py::unregister_exception(g["Custom"].p());
+			try {
+				g["fail"](g["Custom"]);
+			}
+			catch (const custom_err& e) {
+				cout << "still registered" << endl;
+				PyErr_Clear();
+			}
+			catch (const py::err& e) {
+				cout << "unregistered: " << (e.type() == g["Custom"].p()) << endl;
+			}
+			PyErr_Clear();
+		}
+		{
+			cout << ">> hash" << endl;
+			std::unordered_map<py::obj, int> m;
+			m[py::str("abc")] = 1;
+			m[2] = 2;
+			m[py::obj( { 1, "x" })] = 3;
+			cout << m[py::obj("abc")] << m[2] << m[py::obj( { 1, "x" })]
+					<< m.size() << endl;
+			std::unordered_set<py::hashed_obj> hs = { py::obj( { 1, 2 }), py::obj(1.0) };
+			cout << hs.count(py::obj( { 1, 2 })) << hs.count(py::obj(1)) << hs.count(py::obj(3)) << endl;
+			py::obj g = py::import("__main__").a("__dict__");
+			py::obj(PyRun_String("class NoEq(object):\n"
+					"    def __hash__(self): return 1\n"
+					"    def __eq__(self, o): raise ValueError('no eq')\n", Py_file_input, g.p(), g.p()));
+			std::unordered_set<py::obj> ne = { g["NoEq"]() };
+			try {
+				ne.count(g["NoEq"]());
+			} catch (const py::err& e) {
+				cout << "equal_to raised: " << e.what() << endl;
+				PyErr_Clear();
+			}
+			py::dict nd( { });
+			nd.set_item(g["NoEq"](), 1);
+			cout << "try_get, failing __eq__: "
+					<< (nd.try_get(g["NoEq"]()).error().kind() == py::err_kind::val)
+					<< !PyErr_Occurred() << endl;
+
+			std::vector<py::obj> v = { "b", 2.5, py::obj(), 1, "a", py::obj( { 1 }), 3L };
+			std::sort(v.begin(), v.end(), py::less());
+			for (auto& x : v)
+				cout << x << " ";
+			cout << endl;
+			std::vector<py::obj> vs = { "pear", "fig", "apple" };
+			py::fast_sort(vs.begin(), vs.end());
+			cout << vs[0] << " " << vs[1] << " " << vs[2] << endl;
+			std::vector<py::obj> pv;
+			for (int i = 0; i < 40; i++) {
+				py::set s;
+				s = { };
+				for (int k = 0; k < i % 4; k++)
+					s.add(k);
+				pv.push_back(s);
+				pv.push_back(py::obj(i % 3 ? double(i % 5) : Py_NAN));
+				pv.push_back(py::obj( { i % 2, py::obj(i % 7 ? 1.0 : Py_NAN) }));
+			}
+			std::sort(pv.begin(), pv.end(), py::less());
+			bool total = std::is_sorted(pv.begin(), pv.end(), py::less());
+			for (size_t i = 1; i < pv.size(); i++)
+				total = total && !py::less()(pv[i], pv[i - 1]);
+			cout << "partial orders sorted: " << total << " " << pv.front() << " " << pv.back() << endl;
+		}
+		{
+			cout << ">> import" << endl;
+			static py::module_ref os_path("os.path");
+			cout << os_path.a("join")("a", "b") << " " << (py::import("os.path").p() == os_path.get().p()) << endl;
+			auto times = py::preload( { "json", "xml.dom.minidom" }, true);
+			for (auto& t : times)
+				cout << t.name << (t.seconds >= 0 ? " ok " : " bad ");
+			cout << endl;
+		}
+		{
+			cout << ">> def" << endl;
+			py::module_builder("py11_ext", "c++ helpers")
+				.def("add", &ext_add)
+				.def("greet", &ext_greet, "say hi")
+				.def("pair", &ext_pair)
+				.def("fail", &ext_fail)
+				.add("version", 1);
+			py::dict g( { });
+			py::exec("import py11_ext as e\n"
+					"r = [e.add(2, 3), e.greet('bob', 2), e.pair([1], 2), e.fail(False), e.greet.__doc__]\n"
+					"errs = []\n"
+					"for f, a in [(e.add, (1,)), (e.add, (1, 'x')), (e.fail, (True,)), (e.greet, ('x', 2**40))]:\n"
+					"    try: f(*a)\n"
+					"    except Exception as x: errs.append('%s: %s' % (type(x).__name__, x))\n", g);
+			cout << g["r"] << endl;
+			for (auto& x : g["errs"]) {
+				cout << x.c_str() << endl;
+			}
+			cout << py::def("mul", &ext_add)(40, 2) << endl;
+		}
+		{
+			cout << ">> class" << endl;
+			py::class_<ext_point> pc("py11_ext.Point", "a 2d point");
+			pc.init<double, double>()
+				.def_readwrite("x", &ext_point::x)
+				.def_readwrite("y", &ext_point::y)
+				.def_readonly("tag", &ext_point::tag)
+				.def_readwrite("label", &ext_point::label)
+				.def_readwrite("extra", &ext_point::extra)
+				.def_readonly("kind", &ext_point::kind)
+				.def("norm2", &ext_point::norm2)
+				.def("scale", &ext_point::scale);
+			py::dict g( { { "Point", pc.type() }, { "p", py::class_<ext_point>::make(3.0, 4.0) } });
+			py::exec("q = Point(1.5, 2)\n"
+					"q.scale(2)\n"
+					"q.label = 'hi'\n"
+					"q.extra = [1]\n"
+					"r = [p.norm2(), q.x, q.y, q.label, q.extra, q.tag, type(q).__name__, Point.__doc__]\n"
+					"s = Point(0, 0)\n"
+					"Point.__init__(s, 5, 6)\n"
+					"r += [s.x, q.kind, Point.norm2(s)]\n"
+					"errs = []\n"
+					"for s in ['q.tag = 1', 'q.label = 3', 'Point(1)', 'Point.norm2(1)', 'q.kind = \\'x\\'']:\n"
+					"    try: exec s\n"
+					"    except Exception as x: errs.append(type(x).__name__)\n", g);
+			cout << g["r"] << " " << g["errs"] << endl;
+			ext_point* q = py::class_<ext_point>::get(g["q"]);
+			cout << q->x << " " << q->label << " " << (py::class_<ext_point>::get(g["r"]) == NULL) << endl;
+		}
+		{
+			cout << ">> eval" << endl;
+			py::dict g( { });
+			py::exec("import math\nk = 3\n", g);
+			for (int i = 0; i < 3; i++) {
+				cout << py::eval("math.sqrt(k * k) + 1", g) << " ";
+			}
+			cout << py::eval("len('abc')") << endl;
+			auto& cc = py::default_code_cache();
+			cout << "hits: " << cc.hits() << ", misses: " << cc.misses() << endl;
+		}
+		{
+			cout << ">> frozen" << endl;
+			py::obj code = py::eval("compile('n = 6 * 7', 'frozen_test.py', 'exec')",
+				py::dict( { }));
+			py::obj data = py::import("marshal").a("dumps")(code);
+			static std::string bytes(PyString_AS_STRING(data.p()), PyString_GET_SIZE(data.p()));
+			static const py::frozen_module mods[] = {
+				{ "py11_frozen_test", (const unsigned char*)bytes.data(), bytes.size(), false },
+			};
+			py::install_frozen(mods, PyImport_GetMagicNumber());
+			cout << py::import("py11_frozen_test").a("n") << endl;
+			try {
+				py::install_frozen(mods, 1);
+			}
+			catch (const py::val_err& e) {
+				cout << e.what() << endl;
+			}
+		}
+		{
+			cout << ">> gil" << endl;
+			cout << "held: " << py::gil_held() << endl;
+			long r = 0;
+			{
+				py::gil_scoped_release nogil;
+				std::thread th([&r] {
+					py::gil_scoped_acquire gil;
+					r = py::obj(py::import("math").attr("sqrt")(16.0)).as_double();
+				});
+				th.join();
+			}
+			cout << "from thread: " << r << ", held: " << py::gil_held() << endl;
+
+			py::executor ex;
+			std::vector<std::future<double>> fs;
+			for (int i = 0; i < 100; i++) {
+				fs.push_back(ex.submit([i] {
+					return py::import("math").attr("sqrt")(double(i * i)).as_double();
+				}));
+			}
+			py::obj sqrt = py::import("math").attr("sqrt");
+			fs.push_back(ex.submit([sqrt] {return sqrt(0.0).as_double();}));
+			double sum = 0;
+			{
+				py::gil_scoped_release nogil;
+				for (auto& f : fs)
+					sum += f.get();
+			}
+			auto st = ex.stats();
+			cout << "executor sum: " << sum << ", completed: " << st.completed
+					<< ", depth: " << st.queue_depth << endl;
+			auto fe = ex.submit([] {
+				PyErr_SetString(PyExc_ValueError, "left set");
+				return 0;
+			});
+			{
+				py::gil_scoped_release nogil;
+				fe.wait();
+			}
+			try {
+				fe.get();
+			} catch (const py::err& e) {
+				cout << "task error: " << e.what() << endl;
+				PyErr_Clear();
+			}
+
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+			std::promise<double> pr;
+			co_sqrt(ex, py::import("math").attr("sqrt"), pr);
+			{
+				py::gil_scoped_release nogil;
+				cout << "async_call: " << pr.get_future().get() << endl;
+			}
+			std::promise<std::string> ps;
+			py::dict lg( { });
+			py::obj pick(PyRun_String("lambda k: [u'\\xe9\\x00', [1, 2]][k]", Py_eval_input, lg.p(), lg.p()));
+			co_results(ex, pick, ps);
+			{
+				py::gil_scoped_release nogil;
+				std::string s = ps.get_future().get();
+				cout << "async_call results: " << s.size() << " " << s.substr(4) << endl;
+			}
+#endif
+		}
+#if PY11_DEFERRED_DECREF
+		{
+			cout << ">> deferred decref" << endl;
+			py::obj o = py::str("deferred");
+			py::obj* p = new py::obj(o);
+			Py_ssize_t cnt = o.refcnt();
+			{
+				py::gil_scoped_release nogil;
+				std::thread([p] {delete p;}).join();
+			}
+			cout << "refcnt: " << cnt << " -> " << o.refcnt() << endl;
+
+			// a __del__ running python code while the pool drains
+			py::dict g( { });
+			g.set_item("__builtins__", py::obj(PyEval_GetBuiltins(), true));
+			py::obj(PyRun_String("dead = []\n"
+					"class D(object):\n"
+					"    def __del__(self):\n"
+					"        x = [1]\n"
+					"        dead.append(x)\n", Py_file_input, g.p(), g.p()));
+			py::obj* d1 = new py::obj(g["D"]());
+			py::obj* d2 = new py::obj(g["D"]());
+			std::promise<void> released, drained;
+			std::thread th;
+			{
+				py::gil_scoped_release nogil;
+				th = std::thread([&] {
+					delete d1;
+					delete d2;
+					released.set_value();
+					drained.get_future().wait();
+				});
+				released.get_future().wait();
+			}
+			py::drain_decrefs();
+			drained.set_value();
+			{
+				py::gil_scoped_release nogil;
+				th.join();
+			}
+			cout << "__del__ ran: " << py::list(g["dead"]).size() << endl;
+		}
+#endif
+		{
+			cout << ">> process pool" << endl;
+			py::process_pool pool(2, 4096);
+			auto pow = py::import("math").attr("pow");
+			cout << "call: " << pool.call(pow, { 2, 10 }) << endl;
+			cout << "map: " << pool.map(pow, py::list( { { 2, 3 }, { 3, 2 }, { 4, 0.5 } })) << endl;
+			// concurrent maps on a 2 worker pool, each taking what is free
+			py::list args( { { 2, 1 }, { 2, 2 }, { 2, 3 }, { 2, 4 } });
+			py::obj r1, r2;
+			{
+				py::gil_scoped_release nogil;
+				std::thread th([&] {
+					py::gil_scoped_acquire gil;
+					r1 = pool.map(pow, args);
+				});
+				{
+					py::gil_scoped_acquire gil;
+					r2 = pool.map(pow, args);
+				}
+				th.join();
+			}
+			cout << "concurrent map: " << r1 << " " << (r1 == r2) << endl;
+			py::str big = py::str("x") * 10000;
+			cout << "big arg: " << pool.call(py::import("__builtin__").attr("len"),
+							PyTuple_Pack(1, big.p())) << endl;
+			try {
+				pool.call(pow, { "a", 1 });
+			} catch (const py::type_err& e) {
+				cout << "caught: " << e.what() << endl;
+				PyErr_Clear();
+			}
+			try {
+				pool.call(py::import("os").attr("_exit"), PyTuple_Pack(1, py::obj(3).p()));
+			} catch (const py::io_err& e) {
+				cout << "caught: " << e.what() << ", left: " << pool.size() << endl;
+			}
+			cout << "after a lost worker: " << pool.map(pow, args) << endl;
+		}
+		{
+			cout << ">> fork server" << endl;
+			py::fork_options fo;
+			fo.modules = { "json" };
+			py::fork_server fs(fo);
+			pid_t pid = fs.spawn([] {
+				return (int)py::import("json").attr("loads")("[7]")[0].as_long();
+			});
+			cout << "worker exit: " << fs.wait(pid) << endl;
+			pid = fs.spawn([]() -> int {throw 42;});
+			cout << "worker throwing a non-std exception: " << fs.wait(pid) << endl;
+			pid = fs.spawn([] {
+				return py::import("gc").a("get_threshold")()[2].as_long() > 1000000 ? 0 : 1;
+			});
+			cout << "worker threshold raised: " << !fs.wait(pid) << ", server threshold: "
+					<< py::import("gc").a("get_threshold")()[2] << endl;
+			cout << "wait on a stranger: " << fs.wait(1) << endl;
+		}
+		{
+			cout << ">> deadline" << endl;
+			auto builtin = py::import("__builtin__");
+			auto spin = builtin.a("compile")("while 1:\n    pass\n", "<spin>", "exec");
+			try {
+				py::call_with_deadline(builtin.a("eval"), { spin, py::dict( { }) },
+						std::chrono::milliseconds(50));
+			} catch (const py::timeout_err& e) {
+				cout << "caught: " << e.what() << endl;
+			}
+			auto r = py::call_with_deadline(builtin.a("abs"), { -3 }, std::chrono::seconds(5));
+			cout << "usable after timeout: " << r << " " << !PyErr_Occurred() << endl;
+		}
 		{
 			cout << ">> file" << endl;
 			py::file f("test.cpp", "rb");
@@ -126,6 +717,105 @@ int main(int argc, char** argv)
 					break;
 			}
 			cout << "line count: " << cnt << endl;
+			py::file f2("test.cpp", "rb");
+			size_t n = 0, chars = 0, longest = 0;
+			for (auto& l : f2.lines(64)) {
+				n++;
+				chars += l.size();
+				longest = std::max(longest, l.size());
+			}
+			py::file f3("test.cpp", "rb");
+			cout << "lines: " << n << " " << (long(chars) == f3.a("read")().size())
+					<< " " << (longest > 64) << " " << (f3.lines().begin() == f3.lines().end())
+					<< endl;
+			{
+				py::file w("/tmp/py11_lines.txt", "wb");
+				w.write(py::str("a\rb\r\nc\nd\re"), true);
+			}
+			py::file u("/tmp/py11_lines.txt", "rU");
+			std::vector<std::string> ul;
+			for (auto& l : u.lines(4))
+				ul.push_back(l.to_string());
+			cout << "universal lines: " << ul.size() << " " << (ul[1] == "b\r\n") << endl;
+			py::file h("/tmp/py11_lines.txt", "rb");
+			{
+				auto r = h.lines(64);
+				r.begin();
+			}
+			cout << "after lines(): " << h.readline().size() << endl;
+		}
+		{
+			cout << ">> file writer" << endl;
+			{
+				py::file f("/tmp/py11_writer.txt", "wb");
+				py::file_writer w(f, 16);
+				w << "n=" << 42 << ' ' << -7L << ' ' << 0.1 << ' ' << 2.5 << '\n';
+				w << 3.0 << ' ' << -1e22 << ' ' << 1e300 << ' ' << true << ' ' << false << '\n';
+				w.write(py::str("abc")).write(py::obj(3.0)).write(py::str_view("xy", 1));
+				std::vector<std::string> v = { "\nline1", "\nline2\n" };
+				w.writelines(v);
+				w.write(std::string(40, '-'));
+				cout << "pending: " << w.pending() << endl;
+			}
+			py::file r("/tmp/py11_writer.txt", "rb");
+			cout << r.a("read")() << endl;
+		}
+		{
+			cout << ">> read into" << endl;
+			py::file f("/tmp/py11_writer.txt", "rb");
+			py::buffer_pool pool(4);
+			const char* first = NULL;
+			for (int i = 0; i < 2; i++) {
+				auto b = pool.acquire();
+				f.read_exact(b.data(), b.size());
+				cout << std::string(b.data(), b.size()) << " " << (first == NULL || first == b.data()) << " ";
+				first = b.data();
+			}
+			py::obj ba(PyByteArray_FromStringAndSize(NULL, 5));
+			f.read_exact(ba);
+			cout << ba << " ";
+			char rest[256];
+			size_t n = f.read_into(rest, sizeof(rest));
+			cout << n << endl;
+			try {
+				f.read_exact(rest, 1);
+			}
+			catch (const py::eof_err& e) {
+				cout << "caught: " << e.what() << endl;
+			}
+		}
+		{
+			cout << ">> mapped file" << endl;
+			py::file("/tmp/py11_mapped.bin", "wb").write("hello mapped");
+			py::obj mv;
+			{
+				py::mapped_file m("/tmp/py11_mapped.bin", py::mapped_file::read_write);
+				mv = m.memoryview();
+				py::exec("mv[0:5] = 'HELLO'", py::dict( { { "mv", mv } }));
+				cout << m.view() << " " << m.size() << " " << m.writable() << endl;
+				m.data()[6] = 'M';
+				m.flush();
+			}
+			cout << mv.a("tobytes")() << " " << mv.a("readonly") << endl;
+			{
+				// views and slices each hold the mapping
+				py::obj map(PyMemoryView_GET_BUFFER(mv.p())->obj, true);
+				Py_ssize_t cnt = map.refcnt();
+				py::obj part = PySequence_GetSlice(mv.p(), 6, 12);
+				cout << "slice: " << part.a("tobytes")() << " " << (map.refcnt() - cnt);
+				mv.release();
+				part.release();
+				cout << ", left: " << map.refcnt() << endl;
+			}
+			py::mapped_file r("/tmp/py11_mapped.bin");
+			cout << r.view() << " " << r.memoryview().a("readonly") << endl;
+			try {
+				py::mapped_file("/nonexistent/py11");
+			}
+			catch (const py::io_err& e) {
+				cout << "caught: " << e.what() << endl;
+				PyErr_Clear();
+			}
 		}
 		{
 			cout << ">> ref count tests" << endl;
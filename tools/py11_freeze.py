@@ -0,0 +1,98 @@
+#!/usr/bin/env python
+"""Compile python modules into a c++ header, for py::install_frozen.
+
+usage: python py11_freeze.py -o bundle.hpp [-n name] path...
+
+Each path is a .py file, a module named after the file, or a package
+directory, frozen with all its .py files. Run it with the same python
+version the program embeds: the bytecode is version specific.
+
+The header defines `name`, an array of py::frozen_module, and `name_magic`:
+
+    #include "bundle.hpp"
+    py::install_frozen(name, name_magic);
+"""
+
+from __future__ import print_function
+
+import marshal
+import optparse
+import os
+import struct
+import sys
+
+try:
+    from importlib.util import MAGIC_NUMBER as MAGIC
+except ImportError:
+    import imp
+    MAGIC = imp.get_magic()
+
+
+def module(path, name, is_package):
+    with open(path, 'rb') as f:
+        src = f.read()
+    code = compile(src, path, 'exec', 0, True)
+    return name, marshal.dumps(code), is_package
+
+
+def collect(path):
+    path = os.path.normpath(path)
+    if not os.path.isdir(path):
+        name = os.path.splitext(os.path.basename(path))[0]
+        return [module(path, name, False)]
+
+    mods = []
+    top = os.path.dirname(path)
+    for root, dirs, files in os.walk(path):
+        dirs.sort()
+        if '__init__.py' not in files:
+            dirs[:] = []
+            continue
+        pkg = os.path.relpath(root, top).replace(os.sep, '.')
+        for f in sorted(files):
+            if not f.endswith('.py'):
+                continue
+            if f == '__init__.py':
+                mods.append(module(os.path.join(root, f), pkg, True))
+            else:
+                mods.append(module(os.path.join(root, f), pkg + '.' + f[:-3], False))
+    return mods
+
+
+def emit(out, name, mods):
+    out.write('// generated by py11_freeze.py, do not edit\n')
+    out.write('#include <py11/py.hpp>\n\n')
+    for i, (mod, data, _) in enumerate(mods):
+        out.write('// %s\n' % mod)
+        out.write('static const unsigned char %s_%d[] = {\n' % (name, i))
+        data = bytearray(data)
+        for j in range(0, len(data), 16):
+            out.write('    %s,\n' % ','.join('0x%02x' % b for b in data[j:j + 16]))
+        out.write('};\n\n')
+
+    out.write('static const py::frozen_module %s[] = {\n' % name)
+    for i, (mod, _, is_package) in enumerate(mods):
+        out.write('    {"%s", %s_%d, sizeof(%s_%d), %s},\n'
+                  % (mod, name, i, name, i, 'true' if is_package else 'false'))
+    out.write('};\n\n')
+    out.write('static const long %s_magic = %dL;\n' % (name, struct.unpack('<L', MAGIC[:4])[0]))
+
+
+def main():
+    parser = optparse.OptionParser(usage='%prog -o bundle.hpp [-n name] path...')
+    parser.add_option('-o', dest='output', help='header to write')
+    parser.add_option('-n', dest='name', default='py11_bundle', help='c++ name of the bundle')
+    opts, paths = parser.parse_args()
+    if not opts.output or not paths:
+        parser.error('need an output and a path')
+
+    mods = []
+    for p in paths:
+        mods.extend(collect(p))
+    with open(opts.output, 'w') as out:
+        emit(out, opts.name, mods)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())